@@ -0,0 +1,143 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+
+// Benchmark of parallel evaluation of a mixture on a grid.
+//
+// Times Mixture::evaluate, Mixture::marginal and Mixture::partial on a grid
+// for an increasing number of threads (1, 2, 4, ... up to at least 16) and
+// checks that the results do not depend on the number of threads.
+//
+// usage: grid_scaling [ncomponents [npoints [maxthreads]]]
+
+#include "mixture.hpp"
+#include "space.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <typename F>
+double timeit( F fcn ) {
+    auto start = std::chrono::steady_clock::now();
+    fcn();
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+value max_difference( const std::vector<value> & a, const std::vector<value> & b ) {
+    value d = 0.;
+    for (size_t k=0; k<a.size(); ++k) {
+        if (a[k]!=b[k]) {
+            d = std::max( d, std::abs( a[k]-b[k] ) / std::max( std::abs(a[k]), std::abs(b[k]) ) );
+        }
+    }
+    return d;
+}
+
+int main( int argc, char** argv ) {
+    
+    unsigned int ncomponents = argc>1 ? std::atoi( argv[1] ) : 20000;
+    unsigned int npoints = argc>2 ? std::atoi( argv[2] ) : 2000;
+    unsigned int maxthreads = argc>3 ? std::atoi( argv[3] ) : 
+        std::max( 16u, std::thread::hardware_concurrency() );
+    
+    // mixture over two event features and a one-dimensional stimulus
+    EuclideanSpace space( {"a1", "a2", "x"}, {0.3, 0.3, 1.} );
+    EuclideanSpace stimulus( {"x"}, {1.} );
+    
+    std::mt19937 gen( 0 );
+    std::normal_distribution<value> normal( 0., 1. );
+    std::uniform_real_distribution<value> uniform( 0., 100. );
+    
+    std::vector<value> samples;
+    for (unsigned int k=0; k<ncomponents; ++k) {
+        value x = uniform( gen );
+        samples.push_back( x/50. + normal( gen ) );
+        samples.push_back( normal( gen ) );
+        samples.push_back( x );
+    }
+    
+    Mixture mixture( space, 0. );
+    mixture.add_samples( samples.data(), ncomponents );
+    
+    // stimulus grid for marginal and partial evaluation, full grid 
+    // with about the same number of points for evaluation
+    std::vector<value> x( npoints ), a( 10 );
+    for (unsigned int k=0; k<npoints; ++k) { x[k] = k * 100. / npoints; }
+    for (unsigned int k=0; k<a.size(); ++k) { a[k] = -2. + k * 0.5; }
+    std::vector<value> xfull( std::max( 1u, npoints/100 ) );
+    for (unsigned int k=0; k<xfull.size(); ++k) { xfull[k] = k * 100. / xfull.size(); }
+    
+    std::unique_ptr<Grid> stimulus_grid( stimulus.grid( {x} ) );
+    std::unique_ptr<Grid> full_grid( space.grid( {a, a, xfull} ) );
+    
+    std::cout << "components: " << mixture.ncomponents() << ", grid points: " << 
+        stimulus_grid->size() << " (full grid: " << full_grid->size() << 
+        "), hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "evaluate [s]" << 
+        std::setw(14) << "marginal [s]" << std::setw(14) << "partial [s]" << 
+        std::setw(10) << "speedup" << std::setw(14) << "max rel diff" << std::endl;
+    
+    std::vector<value> ref_evaluate, ref_marginal, ref_partial;
+    double ref_total = 0.;
+    
+    std::vector<unsigned int> nthreads;
+    for (unsigned int n=1; n<maxthreads; n*=2) { nthreads.push_back( n ); }
+    nthreads.push_back( maxthreads );
+    
+    for (auto & n : nthreads) {
+        
+        mixture.set_nthreads( n );
+        
+        std::vector<value> evaluate( full_grid->size() );
+        std::vector<value> marginal( stimulus_grid->size(), 0. );
+        std::vector<value> partial( (size_t) mixture.ncomponents() * stimulus_grid->size() );
+        
+        double t_evaluate = timeit( [&]() { mixture.evaluate( *full_grid, evaluate.data() ); } );
+        double t_marginal = timeit( [&]() { mixture.marginal( *stimulus_grid, marginal.data() ); } );
+        double t_partial = timeit( [&]() { mixture.partial( *stimulus_grid, partial.data() ); } );
+        
+        double total = t_evaluate + t_marginal + t_partial;
+        
+        if (n==1) {
+            ref_evaluate = evaluate;
+            ref_marginal = marginal;
+            ref_partial = partial;
+            ref_total = total;
+        }
+        
+        value diff = std::max( { max_difference( evaluate, ref_evaluate ), 
+            max_difference( marginal, ref_marginal ), 
+            max_difference( partial, ref_partial ) } );
+        
+        std::cout << std::setw(8) << n << std::fixed << std::setprecision(4) << 
+            std::setw(14) << t_evaluate << std::setw(14) << t_marginal << 
+            std::setw(14) << t_partial << std::setprecision(2) << 
+            std::setw(10) << ref_total / total << std::scientific << 
+            std::setprecision(1) << std::setw(14) << diff << 
+            std::defaultfloat << std::endl;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,202 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+
+// Benchmark of saving and loading a mixture in HDF5 format.
+//
+// Compares the current layout (chunked and compressed [ndim x K] location 
+// and [nbw x K] bandwidth matrices, written in a single call each) with the
+// previous layout (contiguous datasets written one component at a time,
+// without the optional max_components and min_weight datasets). Reports 
+// save time, load time and file size for both, and checks that files in
+// either layout load back to exactly the same mixture. Returns a non-zero
+// exit code if a file fails to load or differs from the original.
+//
+// usage: hdf5_layout [ncomponents [ndim [directory]]]
+
+#include "mixture.hpp"
+#include "space.hpp"
+
+#include <highfive/H5DataSet.hpp>
+#include <highfive/H5DataSpace.hpp>
+#include <highfive/H5File.hpp>
+#include <highfive/H5Group.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename F>
+double timeit( F fcn ) {
+    auto start = std::chrono::steady_clock::now();
+    fcn();
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+std::streamoff file_size( const std::string & filename ) {
+    std::ifstream stream( filename, std::ios::binary | std::ios::ate );
+    return stream.tellg();
+}
+
+// writes the mixture as Mixture::to_hdf5 did before location and bandwidth
+// were written in bulk to chunked and compressed datasets
+void save_old_layout( const Mixture & mixture, const std::string & filename ) {
+    
+    HighFive::File file( filename, HighFive::File::ReadWrite | 
+        HighFive::File::Create | HighFive::File::Truncate );
+    
+    HighFive::Group group = file.getGroup("/");
+    
+    value sum_of_weights = mixture.sum_of_weights();
+    HighFive::DataSet ds_sow = group.createDataSet<value>("sum_of_weights", HighFive::DataSpace::From(sum_of_weights));
+    ds_sow.write(sum_of_weights);
+    
+    value sum_of_nsamples = mixture.sum_of_nsamples();
+    HighFive::DataSet ds_son = group.createDataSet<value>("sum_of_nsamples", HighFive::DataSpace::From(sum_of_nsamples));
+    ds_son.write(sum_of_nsamples);
+    
+    value threshold = mixture.threshold();
+    HighFive::DataSet ds_th = group.createDataSet<value>("threshold", HighFive::DataSpace::From(threshold));
+    ds_th.write(threshold);
+    
+    unsigned int nkernels = mixture.ncomponents();
+    HighFive::DataSet ds_nk = group.createDataSet<unsigned int>("nkernels", HighFive::DataSpace::From(nkernels));
+    ds_nk.write(nkernels);
+    
+    HighFive::Group space_group = group.createGroup("space");
+    mixture.space().to_hdf5(space_group);
+    
+    auto weights = mixture.weights();
+    HighFive::DataSet ds_w = group.createDataSet<value>("weights", HighFive::DataSpace::From(weights));
+    ds_w.write(weights);
+    
+    HighFive::Group subgroup = group.createGroup("kernels");
+    
+    const ComponentStore & kernels = mixture.components();
+    size_t ndim = mixture.space().ndim();
+    size_t nbw = mixture.space().nbw();
+    
+    HighFive::DataSet ds_loc = subgroup.createDataSet<value>("location",
+        HighFive::DataSpace({ndim, kernels.size()}));
+    
+    HighFive::DataSet ds_bw = subgroup.createDataSet<value>("bandwidth",
+        HighFive::DataSpace({nbw, kernels.size()}));
+    
+    std::vector<value> loc( ndim );
+    std::vector<value> bw( nbw );
+    
+    for (size_t n=0; n<kernels.size(); ++n) {
+        
+        loc.assign( kernels.location(n), kernels.location(n) + ndim );
+        bw.assign( kernels.bandwidth(n), kernels.bandwidth(n) + nbw );
+        
+        ds_loc.select({0,n},{ndim,1}).write(loc);
+        ds_bw.select({0,n},{nbw,1}).write(bw);
+    }
+    
+    file.flush();
+}
+
+bool same_mixture( const Mixture & a, const Mixture & b ) {
+    
+    if (a.ncomponents()!=b.ncomponents() ||
+        a.sum_of_weights()!=b.sum_of_weights() ||
+        a.sum_of_nsamples()!=b.sum_of_nsamples() ||
+        a.threshold()!=b.threshold() ||
+        a.weights()!=b.weights() ||
+        a.space().specification().names()!=b.space().specification().names()) {
+        return false;
+    }
+    
+    return a.components().locations()==b.components().locations() &&
+        a.components().bandwidths()==b.components().bandwidths();
+}
+
+int main( int argc, char** argv ) {
+    
+    unsigned int ncomponents = argc>1 ? std::atoi( argv[1] ) : 200000;
+    unsigned int ndim = argc>2 ? std::atoi( argv[2] ) : 6;
+    std::string directory = argc>3 ? argv[3] : ".";
+    
+    std::vector<std::string> names;
+    for (unsigned int d=0; d<ndim; ++d) { names.push_back( "x" + std::to_string(d) ); }
+    
+    EuclideanSpace space( names, std::vector<value>( ndim, 1. ) );
+    
+    std::mt19937 gen( 0 );
+    std::normal_distribution<value> normal( 0., 10. );
+    
+    std::vector<value> samples( (size_t) ncomponents * ndim );
+    for (auto & s : samples) { s = normal( gen ); }
+    
+    Mixture mixture( space, 0. );
+    mixture.add_samples( samples.data(), ncomponents );
+    
+    std::string new_file = directory + "/hdf5_layout_new.h5";
+    std::string old_file = directory + "/hdf5_layout_old.h5";
+    
+    std::cout << "components: " << mixture.ncomponents() << ", dimensions: " << 
+        ndim << std::endl;
+    std::cout << std::setw(8) << "layout" << std::setw(12) << "save [s]" << 
+        std::setw(12) << "load [s]" << std::setw(12) << "size [MB]" << 
+        std::setw(10) << "match" << std::endl;
+    
+    bool ok = true;
+    
+    auto report = [&]( const std::string & layout, const std::string & filename, 
+        double t_save ) {
+        
+        std::unique_ptr<Mixture> loaded;
+        double t_load = 0.;
+        
+        try {
+            t_load = timeit( [&]() { loaded = Mixture::load_from_hdf5( filename ); } );
+        } catch (std::exception & e) {
+            std::cout << layout << ": cannot load " << filename << ": " << e.what() << std::endl;
+            ok = false;
+            return;
+        }
+        
+        bool match = same_mixture( mixture, *loaded );
+        ok = ok && match;
+        
+        std::cout << std::setw(8) << layout << std::fixed << std::setprecision(3) << 
+            std::setw(12) << t_save << std::setw(12) << t_load << 
+            std::setprecision(1) << std::setw(12) << file_size( filename ) / 1e6 << 
+            std::setw(10) << (match ? "yes" : "NO") << std::defaultfloat << std::endl;
+    };
+    
+    double t_new = timeit( [&]() { mixture.save_to_hdf5( new_file, 
+        HighFive::File::ReadWrite | HighFive::File::Create | HighFive::File::Truncate ); } );
+    report( "current", new_file, t_new );
+    
+    double t_old = timeit( [&]() { save_old_layout( mixture, old_file ); } );
+    report( "old", old_file, t_old );
+    
+    std::remove( new_file.c_str() );
+    std::remove( old_file.c_str() );
+    
+    return ok ? 0 : 1;
+}
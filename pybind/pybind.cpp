@@ -10,6 +10,7 @@ void pybind_mixture( py::module & );
 void pybind_stimulus( py::module & );
 void pybind_likelihood( py::module & );
 void pybind_decoder( py::module & );
+void pybind_streaming_decoder( py::module & );
 
 PYBIND11_MODULE(compressed_kde, m) {
     py::options options;
@@ -73,11 +74,13 @@ PYBIND11_MODULE(compressed_kde, m) {
                                               Stimulus
                                               PoissonLikelihood
                                               Decoder
+                                              StreamingDecoder
 
                                       )pbdoc");
 
     pybind_stimulus(subm);
     pybind_likelihood(subm);
     pybind_decoder(subm);
+    pybind_streaming_decoder(subm);
     
 }
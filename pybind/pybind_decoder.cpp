@@ -38,6 +38,15 @@ void pybind_decoder(py::module &m) {
     .def_property_readonly("nsources", &Decoder::nsources,
     R"pbdoc(Number of sources (likelihoods).)pbdoc")
     
+    .def_property("nthreads", &Decoder::nthreads, &Decoder::set_nthreads,
+    R"pbdoc(Number of threads used for decoding (0 = number of hardware threads).)pbdoc")
+    
+    .def_property_readonly("prepared", &Decoder::prepared,
+    R"pbdoc(Whether all likelihoods are precomputed.)pbdoc")
+    
+    .def("prepare", &Decoder::prepare,
+    R"pbdoc(Precompute all likelihoods that have changed.)pbdoc")
+    
     .def_property_readonly("is_union", &Decoder::is_union,
     R"pbdoc(Whether decoding is performed over union of stimulus spaces.)pbdoc")
     
@@ -234,6 +243,41 @@ void pybind_decoder(py::module &m) {
         
     )pbdoc" )
     
+    .def("save_to_flatbuffers_file", &Decoder::save_to_flatbuffers_file,
+    py::arg("filename"),
+    R"pbdoc(
+        save_to_flatbuffers_file(filename) -> None
+
+        Save decoder to flatbuffers file. An existing file is replaced
+        only after the new file has been written completely, so that
+        objects loaded from the existing file remain valid.
+
+        Parameters
+        ----------
+        filename : str
+            path to flatbuffers file
+
+    )pbdoc" )
+
+    .def_static("load_from_flatbuffers_file", [](std::string filename) { return std::unique_ptr<Decoder>( Decoder::load_from_flatbuffers_file(filename) ); },
+    py::arg("filename"),
+    R"pbdoc(
+        load_from_flatbuffers_file(filename) -> Decoder
+
+        Load decoder from memory-mapped flatbuffers file. Components
+        are not copied, but refer to the mapped file until they are modified.
+        
+        Parameters
+        ----------
+        filename : string
+            path to flatbuffers file
+        
+        Returns
+        -------
+        Decoder
+        
+    )pbdoc" )
+    
     .def(py::pickle(
         &(pickle_get_state<Decoder>),
         &(pickle_set_state<Decoder, fb_serialize::Decoder>)
@@ -280,7 +324,12 @@ void pybind_decoder(py::module &m) {
             events_n.push_back( buf.size );
         }
         
-        obj.decode( events_data, events_n, delta_t, out_ptr, normalize );
+        // decode without holding the GIL, so that python threads can decode concurrently
+        obj.prepare();
+        {
+            py::gil_scoped_release release;
+            static_cast<const Decoder&>(obj).decode( events_data, events_n, delta_t, out_ptr, normalize );
+        }
         
         return out;
         
@@ -335,7 +384,12 @@ void pybind_decoder(py::module &m) {
             events_n.push_back( buf.size );
         }
         
-        obj.decode( events_data, events_n, delta_t, (value*) result_buf.ptr, index, normalize );
+        // decode without holding the GIL, so that python threads can decode concurrently
+        obj.prepare();
+        {
+            py::gil_scoped_release release;
+            static_cast<const Decoder&>(obj).decode( events_data, events_n, delta_t, (value*) result_buf.ptr, index, normalize );
+        }
         
         return result;
         
@@ -360,6 +414,189 @@ void pybind_decoder(py::module &m) {
         -------
         posterior distribution for selected stimulus space.
         
+    )pbdoc")
+    .def("decode_batch", [](Decoder & obj, std::vector<py::array_t<value, py::array::c_style | py::array::forcecast>> events, std::vector<py::array_t<unsigned int, py::array::c_style | py::array::forcecast>> bins, unsigned int nbins, value delta_t, unsigned int index, bool normalize)->py::array_t<value> {
+        
+        if (index>=obj.n_union()) {
+            throw std::runtime_error("Union index out of bounds.");
+        }
+        
+        if (bins.size()!=events.size()) {
+            throw std::runtime_error("Provide bin indices for each source.");
+        }
+        
+        std::vector<long unsigned int> shape = { nbins };
+        shape.insert( shape.end(), obj.grid_shape(index).begin(), obj.grid_shape(index).end() );
+        
+        std::vector<long unsigned int> strides(shape.size(), sizeof(value));
+        for (int s=shape.size()-2; s>=0; --s) {
+            strides[s] = strides[s+1] * shape[s+1];
+        }
+        
+        // construct array buffer
+        auto result = py::array( py::buffer_info(
+            nullptr,
+            sizeof(value),
+            py::format_descriptor<value>::value,
+            strides.size(),
+            shape,
+            strides
+        ));
+        
+        auto result_buf = result.request();
+        
+        std::fill( (value*) result_buf.ptr, ((value*) result_buf.ptr) + nbins * obj.grid_size(index), 0. );
+        
+        // construct vector of data pointers
+        std::vector<value*> events_data;
+        std::vector<unsigned int> events_n;
+        std::vector<unsigned int*> bins_data;
+        
+        for (unsigned int k=0; k<events.size(); ++k) {
+            auto buf = events[k].request();
+            auto bins_buf = bins[k].request();
+            
+            if (bins_buf.size * obj.likelihood(k, index)->ndim_events() != buf.size) {
+                throw std::runtime_error("Provide a bin index for each event.");
+            }
+            
+            events_data.push_back( (value*) buf.ptr );
+            events_n.push_back( buf.size );
+            bins_data.push_back( (unsigned int*) bins_buf.ptr );
+        }
+        
+        // decode without holding the GIL, so that python threads can decode concurrently
+        obj.prepare();
+        {
+            py::gil_scoped_release release;
+            static_cast<const Decoder&>(obj).decode_batch( events_data, events_n, bins_data, nbins, delta_t, (value*) result_buf.ptr, index, normalize );
+        }
+        
+        return result;
+        
+    }, py::arg("events"), py::arg("bins"), py::arg("nbins"), py::arg("delta"), py::arg("index")=0, py::arg("normalize")=true,
+    R"pbdoc(
+        decode_batch(events, bins, nbins, delta, index, normalize)-> array
+        
+        Compute posterior probability distributions for multiple time bins
+        and single stimulus space.
+        
+        Parameters
+        ----------
+        events : list of (n,ndim) arrays
+            A list with for each source the observed event data.
+        bins : list of (n,) arrays
+            A list with for each source the (non-decreasing) time bin index
+            of each event.
+        nbins : int
+            Number of time bins.
+        delta : float
+            Time duration of each bin.
+        index : int
+            Index of stimulus space in union that is target of decoding.
+        normalize : bool
+            Normalize posterior distributions such that they sum to one.
+        
+        Returns
+        -------
+        (nbins, ...) array with posterior distribution for each time bin.
+        
+    )pbdoc")
+    .def("decode_sliding", [](Decoder & obj, std::vector<py::array_t<value, py::array::c_style | py::array::forcecast>> events, std::vector<py::array_t<unsigned int, py::array::c_style | py::array::forcecast>> bins, unsigned int nbins, unsigned int window, value delta_t, unsigned int index, bool normalize)->py::array_t<value> {
+        
+        if (index>=obj.n_union()) {
+            throw std::runtime_error("Union index out of bounds.");
+        }
+        
+        if (bins.size()!=events.size()) {
+            throw std::runtime_error("Provide bin indices for each source.");
+        }
+        
+        if (window==0 || window>nbins) {
+            throw std::runtime_error("Window should span at least one and at most all time bins.");
+        }
+        
+        auto grid_shape = obj.grid_shape(index);
+        
+        std::vector<long unsigned int> shape = { nbins + 1 - window };
+        shape.insert( shape.end(), grid_shape.begin(), grid_shape.end() );
+        
+        std::vector<long unsigned int> strides(shape.size(), sizeof(value));
+        for (int s=shape.size()-2; s>=0; --s) {
+            strides[s] = strides[s+1] * shape[s+1];
+        }
+        
+        // construct array buffer
+        auto result = py::array( py::buffer_info(
+            nullptr,
+            sizeof(value),
+            py::format_descriptor<value>::value,
+            strides.size(),
+            shape,
+            strides
+        ));
+        
+        auto result_buf = result.request();
+        
+        // construct vector of data pointers
+        std::vector<value*> events_data;
+        std::vector<unsigned int> events_n;
+        std::vector<unsigned int*> bins_data;
+        
+        for (unsigned int k=0; k<events.size(); ++k) {
+            auto buf = events[k].request();
+            auto bins_buf = bins[k].request();
+            
+            if (bins_buf.size * obj.likelihood(k, index)->ndim_events() != buf.size) {
+                throw std::runtime_error("Provide a bin index for each event.");
+            }
+            
+            events_data.push_back( (value*) buf.ptr );
+            events_n.push_back( buf.size );
+            bins_data.push_back( (unsigned int*) bins_buf.ptr );
+        }
+        
+        // decode without holding the GIL, so that python threads can decode concurrently
+        obj.prepare();
+        {
+            py::gil_scoped_release release;
+            static_cast<const Decoder&>(obj).decode_sliding( events_data, events_n, bins_data, nbins, window, delta_t, (value*) result_buf.ptr, index, normalize );
+        }
+        
+        return result;
+        
+    }, py::arg("events"), py::arg("bins"), py::arg("nbins"), py::arg("window"), py::arg("delta"), py::arg("index")=0, py::arg("normalize")=true,
+    R"pbdoc(
+        decode_sliding(events, bins, nbins, window, delta, index, normalize)-> array
+        
+        Compute posterior probability distributions for overlapping time
+        windows and single stimulus space. Window k spans the time bins
+        [k, k+window). Each event is evaluated once for its time bin and
+        windows are decoded from running sums over bins, such that the
+        cost does not grow with the overlap of windows.
+        
+        Parameters
+        ----------
+        events : list of (n,ndim) arrays
+            A list with for each source the observed event data.
+        bins : list of (n,) arrays
+            A list with for each source the (non-decreasing) time bin index
+            of each event.
+        nbins : int
+            Number of time bins.
+        window : int
+            Number of time bins in a window.
+        delta : float
+            Time duration of each bin.
+        index : int
+            Index of stimulus space in union that is target of decoding.
+        normalize : bool
+            Normalize posterior distributions such that they sum to one.
+        
+        Returns
+        -------
+        (nbins-window+1, ...) array with posterior distribution for each window.
+        
     )pbdoc");
 
 }
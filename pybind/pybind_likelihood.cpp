@@ -63,6 +63,14 @@ void pybind_likelihood(py::module &m) {
     .def_property_readonly("stimulus", &PoissonLikelihood::stimulus,
     R"pbdoc(Stimulus occupancy.)pbdoc")
     
+    .def_property("max_components", &PoissonLikelihood::max_components, &PoissonLikelihood::set_max_components,
+    R"pbdoc(Maximum number of components in event distribution (0 means unbounded).)pbdoc")
+    .def_property("min_weight", &PoissonLikelihood::min_weight, &PoissonLikelihood::set_min_weight,
+    R"pbdoc(Minimum component weight in event distribution (0 means no minimum).)pbdoc")
+    .def_property("nthreads", &PoissonLikelihood::nthreads, &PoissonLikelihood::set_nthreads,
+    R"pbdoc(Number of threads used for precomputation (0 = number of hardware threads).)pbdoc")
+    .def_property("save_precomputed", &PoissonLikelihood::save_precomputed, &PoissonLikelihood::set_save_precomputed,
+    R"pbdoc(Save up-to-date precomputed state with the likelihood, which is restored on loading if the model did not change.)pbdoc")
     .def_property("random_insertion", &PoissonLikelihood::random_insertion, &PoissonLikelihood::set_random_insertion,
     R"pbdoc(Randomize new samples before merging into distribution.)pbdoc")
     
@@ -70,6 +78,9 @@ void pybind_likelihood(py::module &m) {
     .def_property("rate_scale", &PoissonLikelihood::rate_scale, &PoissonLikelihood::set_rate_scale,
     R"pbdoc(Event rate scaling factor that is applied during likelihood evaluation.)pbdoc")
     
+    .def_property("background_precompute", &PoissonLikelihood::background_precompute, &PoissonLikelihood::set_background_precompute,
+    R"pbdoc(Whether intermediate computations are updated on a background thread, while evaluation uses the previous results.)pbdoc")
+    
     .def("to_yaml", [](PoissonLikelihood &m, bool b)->std::string {
         YAML::Emitter out;
         YAML::Node node = m.to_yaml(b);
@@ -188,9 +199,40 @@ void pybind_likelihood(py::module &m) {
         
     )pbdoc" )
         
+    .def("merge_likelihood", &PoissonLikelihood::merge_likelihood, py::arg("other"),
+    R"pbdoc(
+        merge_likelihood(other) -> None
+
+        Merge event distribution of other likelihood with the same event
+        space and grid. The stimulus occupancy is not merged, use 
+        Stimulus.merge_stimulus if the likelihoods do not share the same
+        stimulus occupancy.
+        
+        Parameters
+        ----------
+        other : PoissonLikelihood
+        
+    )pbdoc")
+    
+    .def("reduce", &PoissonLikelihood::reduce, py::arg("ncomponents"),
+    R"pbdoc(Merge closest components of event distribution until at most ncomponents remain.)pbdoc")
+    
+    .def("reduce_threshold", &PoissonLikelihood::reduce_threshold, py::arg("threshold"),
+    R"pbdoc(Merge components of event distribution that are closer than the new compression threshold.)pbdoc")
+    
     .def("precompute", &PoissonLikelihood::precompute, 
     R"pbdoc(Execute and cache intermediate computations.)pbdoc")
     
+    .def("prepare", &PoissonLikelihood::prepare, 
+    R"pbdoc(Execute and cache intermediate computations if likelihood has changed.)pbdoc")
+    
+    .def("precompute_async", &PoissonLikelihood::precompute_async, 
+    R"pbdoc(Execute intermediate computations on a background thread.)pbdoc")
+    
+    .def("wait_precompute", &PoissonLikelihood::wait_precompute, 
+    py::call_guard<py::gil_scoped_release>(),
+    R"pbdoc(Wait for background computations to finish.)pbdoc")
+    
     .def_property_readonly("stimulus_logp", [](const PoissonLikelihood & obj)->py::array_t<value> {
         
         std::vector<long unsigned int> strides(obj.grid().ndim(), sizeof(value));
@@ -198,9 +240,11 @@ void pybind_likelihood(py::module &m) {
             strides[k] = strides[k+1] * obj.grid().shape()[k+1];
         }
         
+        auto data = obj.stimulus_logp();
+        
         // create output buffer
         auto result = py::array( py::buffer_info(
-            const_cast<value*>(obj.stimulus_logp().data()),
+            data.data(),
             sizeof(value),
             py::format_descriptor<value>::value,
             obj.grid().ndim(),
@@ -220,9 +264,11 @@ void pybind_likelihood(py::module &m) {
             strides[k] = strides[k+1] * obj.grid().shape()[k+1];
         }
         
+        auto data = obj.event_rate();
+        
         // create output buffer
         auto result = py::array( py::buffer_info(
-            const_cast<value*>(obj.event_rate().data()),
+            data.data(),
             sizeof(value),
             py::format_descriptor<value>::value,
             obj.grid().ndim(),
@@ -400,6 +446,7 @@ void pybind_likelihood(py::module &m) {
         
         std::fill( (value*) result_buf.ptr, ((value*) result_buf.ptr) + obj.grid().size(), 0. );
         
+        obj.prepare();
         obj.event_prob( (value *) buf.ptr, nsamples, (value *) result_buf.ptr );
         
         return result;
@@ -454,6 +501,7 @@ void pybind_likelihood(py::module &m) {
         
         std::fill( (value*) result_buf.ptr, ((value*) result_buf.ptr) + obj.grid().size(), 0. );
         
+        obj.prepare();
         obj.event_logp( (value *) buf.ptr, nsamples, (value *) result_buf.ptr );
         
         return result;
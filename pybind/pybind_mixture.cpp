@@ -28,6 +28,12 @@ void pybind_mixture(py::module &m) {
     R"pbdoc(Number of samples that were added to the density.)pbdoc")
     .def_property("threshold", &Mixture::threshold, &Mixture::set_threshold,
     R"pbdoc(Compression threshold.)pbdoc")
+    .def_property("max_components", &Mixture::max_components, &Mixture::set_max_components,
+    R"pbdoc(Maximum number of components (0 means unbounded). When exceeded, the lowest weight components are removed until 90% of the maximum remains.)pbdoc")
+    .def_property("min_weight", &Mixture::min_weight, &Mixture::set_min_weight,
+    R"pbdoc(Minimum component weight (0 means no minimum). When a component falls below it, all components with a weight below min_weight/0.9 are removed.)pbdoc")
+    .def_property("nthreads", &Mixture::nthreads, &Mixture::set_nthreads,
+    R"pbdoc(Number of threads used for evaluation on grids (0 = number of hardware threads).)pbdoc")
     .def_property_readonly("ncomponents", &Mixture::ncomponents,
     R"pbdoc(Number of components in (compressed) density.)pbdoc")
     .def_property_readonly("weights", &Mixture::weights,
@@ -48,10 +54,8 @@ void pybind_mixture(py::module &m) {
         
         value* ptr = (value*) result_buf.ptr;
         
-        for (auto const & c : obj.components()) {
-            std::copy( c->location.begin(), c->location.end(), ptr );
-            ptr += obj.space().ndim();
-        }
+        auto locations = obj.components().locations();
+        std::copy( locations.begin(), locations.end(), ptr );
         
         return result;
         
@@ -73,10 +77,8 @@ void pybind_mixture(py::module &m) {
         
         value* ptr = (value*) result_buf.ptr;
         
-        for (auto const & c : obj.components()) {
-            std::copy( c->bandwidth.begin(), c->bandwidth.end(), ptr );
-            ptr += obj.space().nbw();
-        }
+        auto bandwidths = obj.components().bandwidths();
+        std::copy( bandwidths.begin(), bandwidths.end(), ptr );
         
         return result;
         
@@ -98,9 +100,8 @@ void pybind_mixture(py::module &m) {
         
         value* ptr = (value*) result_buf.ptr;
         
-        for (auto const & c : obj.components()) {
-            *ptr++ = c->scale_factor;
-        }
+        auto scale_factors = obj.components().scale_factors();
+        std::copy( scale_factors.begin(), scale_factors.end(), ptr );
         
         return result;
         
@@ -216,6 +217,41 @@ void pybind_mixture(py::module &m) {
         
     )pbdoc" )
     
+    .def("save_to_flatbuffers_file", &Mixture::save_to_flatbuffers_file,
+    py::arg("filename"),
+    R"pbdoc(
+        save_to_flatbuffers_file(filename) -> None
+
+        Save mixture to flatbuffers file. An existing file is replaced
+        only after the new file has been written completely, so that
+        objects loaded from the existing file remain valid.
+
+        Parameters
+        ----------
+        filename : str
+            path to flatbuffers file
+
+    )pbdoc" )
+
+    .def_static("load_from_flatbuffers_file", [](std::string filename) { return std::unique_ptr<Mixture>( Mixture::load_from_flatbuffers_file(filename) ); },
+    py::arg("filename"),
+    R"pbdoc(
+        load_from_flatbuffers_file(filename) -> Mixture
+
+        Load mixture from memory-mapped flatbuffers file. Components
+        are not copied, but refer to the mapped file until they are modified.
+        
+        Parameters
+        ----------
+        filename : string
+            path to flatbuffers file
+        
+        Returns
+        -------
+        Mixture
+        
+    )pbdoc" )
+    
     .def(py::pickle(
         &(pickle_get_state<Mixture>),
         &(pickle_set_state<Mixture, fb_serialize::Mixture>)
@@ -289,6 +325,57 @@ void pybind_mixture(py::module &m) {
         
     )pbdoc")
     
+    .def("merge_mixture", &Mixture::merge_mixture, py::arg("other"),
+    R"pbdoc(
+        merge_mixture(other) -> None
+
+        Merge other mixture into the mixture.
+        
+        The components of the other mixture are merged with existing
+        components if the mahalanobis distance is below the threshold.
+        Weights of both mixtures are combined according to their sum
+        of weights.
+        
+        Parameters
+        ----------
+        other : Mixture
+            Mixture in the same space.
+        
+    )pbdoc")
+    
+    .def("reduce", &Mixture::reduce, py::arg("ncomponents"),
+    R"pbdoc(
+        reduce(ncomponents) -> None
+
+        Reduce the number of components.
+        
+        The closest pairs of components (in mahalanobis distance) are 
+        merged one after the other, until at most ncomponents remain.
+        
+        Parameters
+        ----------
+        ncomponents : int
+            Target number of components.
+        
+    )pbdoc")
+    
+    .def("reduce_threshold", &Mixture::reduce_threshold, py::arg("threshold"),
+    R"pbdoc(
+        reduce_threshold(threshold) -> None
+
+        Compress the mixture with a new threshold.
+        
+        The closest pairs of components (in mahalanobis distance) are 
+        merged one after the other, until no pair of components is closer 
+        than the threshold. The new threshold is used for subsequent merges.
+        
+        Parameters
+        ----------
+        threshold : scalar
+            New compression threshold.
+        
+    )pbdoc")
+    
     .def("evaluate", [](Mixture &m, py::array_t<value, py::array::c_style | py::array::forcecast> samples)->py::array_t<value> {
         
         unsigned int ndim = m.space().ndim();
@@ -577,6 +664,8 @@ void pybind_mixture(py::module &m) {
     R"pbdoc(Number of partially evaluated samples.)pbdoc")
     .def_property_readonly("partial_shape", &PartialMixture::partial_shape,
     R"pbdoc(Array shape of partially evaluated samples.)pbdoc")
+    .def_property_readonly("factorized", &PartialMixture::factorized,
+    R"pbdoc(Whether per axis terms of a separable grid are stored.)pbdoc")
     
     .def("mixture", &PartialMixture::mixture, py::return_value_policy::reference_internal,
     R"pbdoc(Parent mixture.)pbdoc")
@@ -595,7 +684,8 @@ void pybind_mixture(py::module &m) {
         auto result_buf = result.request();
         
         // copy values
-        std::copy( m.partial_logp().cbegin(), m.partial_logp().cend(), (value*) result_buf.ptr );
+        auto logp = m.partial_logp();
+        std::copy( logp.cbegin(), logp.cend(), (value*) result_buf.ptr );
         
         return result;
         
@@ -37,6 +37,15 @@ void pybind_stimulus(py::module &m) {
     .def_property("random_insertion", &StimulusOccupancy::random_insertion, &StimulusOccupancy::set_random_insertion,
     R"pbdoc(Whether new stimuli will be merged into the distribution in randomized order.)pbdoc")
     
+    .def_property("max_components", &StimulusOccupancy::max_components, &StimulusOccupancy::set_max_components,
+    R"pbdoc(Maximum number of components in stimulus distribution (0 means unbounded).)pbdoc")
+    
+    .def_property("min_weight", &StimulusOccupancy::min_weight, &StimulusOccupancy::set_min_weight,
+    R"pbdoc(Minimum component weight in stimulus distribution (0 means no minimum).)pbdoc")
+    
+    .def_property("nthreads", &StimulusOccupancy::nthreads, &StimulusOccupancy::set_nthreads,
+    R"pbdoc(Number of threads used for evaluation on grid (0 = number of hardware threads).)pbdoc")
+    
     .def_property_readonly("space", py::cpp_function(&StimulusOccupancy::space, py::return_value_policy::reference_internal),
     R"pbdoc(Stimulus space.)pbdoc")
     
@@ -146,6 +155,19 @@ void pybind_stimulus(py::module &m) {
         
     )pbdoc")
     
+    .def("merge_stimulus", &StimulusOccupancy::merge_stimulus, py::arg("other"),
+    R"pbdoc(
+        merge_stimulus(other) -> None
+
+        Merge stimulus distribution of other stimulus occupancy with the 
+        same space, grid and stimulus duration.
+        
+        Parameters
+        ----------
+        other : Stimulus
+        
+    )pbdoc")
+    
     .def("occupancy", [](StimulusOccupancy & obj)->py::array_t<value> {
         
         std::vector<long unsigned int> strides(obj.grid().ndim(), sizeof(value));
@@ -0,0 +1,171 @@
+#include "pybind.hpp"
+
+#include "streaming_decoder.hpp"
+
+void pybind_streaming_decoder(py::module &m) {
+
+    py::class_<StreamingDecoder>(m, "StreamingDecoder",
+    R"pbdoc(
+        Streaming decoder class.
+        
+        Long-lived decoder for continuous streams of events. Events are
+        pushed for each source into a lock-free ring buffer (one producer
+        thread per source) and posteriors are computed for time bins of
+        duration `bin_size` that start every `step` seconds. Bin k covers the
+        interval [origin + k*step, origin + k*step + bin_size), such that
+        bins overlap if step is smaller than bin_size.
+        
+        .. py:function:: StreamingDecoder( decoder, bin_size, step, capacity, index, normalize, origin )
+        
+        Parameters
+        ----------
+        decoder : Decoder
+            Decoder with likelihoods for all sources. The likelihoods should
+            not be modified while streaming.
+        bin_size : float
+            Duration of time bins.
+        step : float
+            Time between the start of consecutive bins. A value of 0 selects
+            non-overlapping bins.
+        capacity : int
+            Number of events per source that can be buffered.
+        index : int
+            Index of stimulus space in union that is target of decoding.
+        normalize : bool
+            Normalize posterior distributions such that they sum to one.
+        origin : float
+            Start time of the first bin.
+        
+    )pbdoc")
+    
+    .def( py::init<Decoder &, value, value, unsigned int, unsigned int, bool, double>(), 
+        py::arg("decoder"), py::arg("bin_size"), py::arg("step")=0., 
+        py::arg("capacity")=DEFAULT_STREAM_CAPACITY, py::arg("index")=0, 
+        py::arg("normalize")=true, py::arg("origin")=0., py::keep_alive<1,2>() )
+    
+    .def_property_readonly("nsources", &StreamingDecoder::nsources,
+    R"pbdoc(Number of sources.)pbdoc")
+    .def_property_readonly("bin_size", &StreamingDecoder::bin_size,
+    R"pbdoc(Duration of time bins.)pbdoc")
+    .def_property_readonly("step", &StreamingDecoder::step,
+    R"pbdoc(Time between the start of consecutive bins.)pbdoc")
+    .def_property_readonly("capacity", &StreamingDecoder::capacity,
+    R"pbdoc(Number of events per source that can be buffered.)pbdoc")
+    .def_property_readonly("index", &StreamingDecoder::index,
+    R"pbdoc(Index of stimulus space in union that is target of decoding.)pbdoc")
+    .def_property_readonly("window", &StreamingDecoder::window,
+    R"pbdoc(Number of steps per bin if bins are decoded from running sums of steps, or 0 if every bin is decoded separately.)pbdoc")
+    .def_property_readonly("next_bin", &StreamingDecoder::next_bin,
+    R"pbdoc(Index of the next bin that will be emitted.)pbdoc")
+    .def_property_readonly("next_bin_start", &StreamingDecoder::next_bin_start,
+    R"pbdoc(Start time of the next bin that will be emitted.)pbdoc")
+    .def_property_readonly("next_bin_stop", &StreamingDecoder::next_bin_stop,
+    R"pbdoc(End time of the next bin that will be emitted.)pbdoc")
+    .def_property_readonly("last_latency", &StreamingDecoder::last_latency,
+    R"pbdoc(Latency (in seconds) of the last emitted bin.)pbdoc")
+    .def_property_readonly("max_latency", &StreamingDecoder::max_latency,
+    R"pbdoc(Maximum latency (in seconds) of all emitted bins.)pbdoc")
+    
+    .def("dropped", &StreamingDecoder::dropped, py::arg("source"),
+    R"pbdoc(
+        dropped(source) -> int
+        
+        Number of events of a source that were dropped, because the
+        buffers were full or the events were too late or out of order.
+        
+    )pbdoc")
+    
+    .def("push", [](StreamingDecoder & obj, unsigned int source, py::array_t<double, py::array::c_style | py::array::forcecast> times, py::array_t<value, py::array::c_style | py::array::forcecast> events)->unsigned int {
+        
+        auto times_buf = times.request();
+        auto events_buf = events.request();
+        
+        if (events_buf.size != times_buf.size * obj.ndim_events(source)) {
+            throw std::runtime_error("Number of event values does not match number of time stamps.");
+        }
+        
+        return obj.push( source, (double*) times_buf.ptr, (value*) events_buf.ptr, times_buf.size );
+        
+    }, py::arg("source"), py::arg("times"), py::arg("events"),
+    R"pbdoc(
+        push(source, times, events) -> int
+        
+        Buffer timestamped events of a single source. Events of a source
+        should be pushed in non-decreasing time order from a single thread.
+        
+        Parameters
+        ----------
+        source : int
+        times : (n,) array
+        events : (n,ndim) array
+        
+        Returns
+        -------
+        number of buffered events
+        
+    )pbdoc")
+    
+    .def("process", [](StreamingDecoder & obj, double time)->py::tuple {
+        
+        std::vector<double> start;
+        std::vector<double> latency;
+        std::vector<value> posterior;
+        
+        {
+            py::gil_scoped_release release;
+            obj.process( time, [&](const StreamingDecoder::Bin & bin) {
+                start.push_back( bin.start );
+                latency.push_back( bin.latency );
+                posterior.insert( posterior.end(), bin.posterior, bin.posterior + obj.grid_size() );
+            });
+        }
+        
+        auto grid_shape = obj.decoder().grid_shape( obj.index() );
+        
+        std::vector<long unsigned int> shape = { start.size() };
+        shape.insert( shape.end(), grid_shape.begin(), grid_shape.end() );
+        
+        std::vector<long unsigned int> strides(shape.size(), sizeof(value));
+        for (int s=shape.size()-2; s>=0; --s) {
+            strides[s] = strides[s+1] * shape[s+1];
+        }
+        
+        auto result = py::array( py::buffer_info(
+            nullptr,
+            sizeof(value),
+            py::format_descriptor<value>::value,
+            strides.size(),
+            shape,
+            strides
+        ));
+        
+        auto result_buf = result.request();
+        std::copy( posterior.begin(), posterior.end(), (value*) result_buf.ptr );
+        
+        return py::make_tuple( py::array_t<double>( start.size(), start.data() ), 
+            result, py::array_t<double>( latency.size(), latency.data() ) );
+        
+    }, py::arg("time"),
+    R"pbdoc(
+        process(time) -> (array, array, array)
+        
+        Decode all bins that end at or before time.
+        
+        Parameters
+        ----------
+        time : float
+            Current stream time.
+        
+        Returns
+        -------
+        start : (nbins,) array
+            Start time of each emitted bin.
+        posterior : (nbins, ...) array
+            Posterior distribution for each emitted bin.
+        latency : (nbins,) array
+            Time (in seconds) from the call to process until the posterior
+            of each bin was computed.
+        
+    )pbdoc");
+
+}
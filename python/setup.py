@@ -64,13 +64,15 @@ include_dirs = [
 ]
 
 library_dirs = []
+link_args = []
 
 if sys.platform.startswith('win'):
     compile_args = ['/std:c++17', '-DH5_BUILT_AS_DYNAMIC_LIB', '/O2']
     include_dirs.append(os.path.join(get_config_var('prefix'), 'Library', 'include'))
     library_dirs.append(os.path.join(get_config_var('prefix'), 'Library', 'lib'))
 elif sys.platform.startswith('linux'):
-    compile_args = ['-std=c++17', '-O3']
+    compile_args = ['-std=c++17', '-O3', '-pthread']
+    link_args = ['-pthread']
 else:
     compile_args = []
 
@@ -84,6 +86,7 @@ extensions = [
         library_dirs = library_dirs,
         language = "c++",
         extra_compile_args = compile_args,
+        extra_link_args = link_args,
     )
 ]
 
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 #include <stdexcept>
+#include <cstring>
 
 #include <numeric>
 
@@ -52,6 +53,133 @@ float fastlog (float x) {
   return 0.69314718f * fastlog2 (x);
 }
 
+// batch versions
+// the loops below are written such that the compiler can vectorize them.
+// with gcc or clang on x86-64, versions for several instruction sets are
+// compiled and the best one for the cpu is selected on first use (not at
+// load time, which would precede the initialization of sanitizers).
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define FAST_DISPATCH
+#define FAST_INLINE inline __attribute__((always_inline))
+#else
+#define FAST_INLINE inline
+#endif
+
+// no fused multiply-add, such that all versions give the same results as 
+// the scalar functions, independent of the position of a value in the array
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+// same as scalar functions, but without branches and with signed integer
+// conversions, so that they vectorize (identical results for valid input)
+static FAST_INLINE float fastpow2_inline (float p) {
+  float offset = (float) (p < 0);
+  // clip at -126 using bit mask
+  int32_t mask = -(int32_t) (p < -126);
+  union { float f; int32_t i; } vp = { p }, vc = { -126.0f };
+  union { int32_t i; float f; } vclip = { (vp.i & ~mask) | (vc.i & mask) };
+  float clipp = vclip.f;
+  int32_t w = clipp;
+  float z = clipp - w + offset;
+  union { int32_t i; float f; } v = { (int32_t) ( (1 << 23) * (clipp + 121.2740575f + 27.7280233f / (4.84252568f - z) - 1.49012907f * z) ) };
+  
+  return v.f;
+}
+
+static FAST_INLINE float fastlog2_inline (float x) {
+  union { float f; int32_t i; } vx = { x };
+  union { int32_t i; float f; } mx = { (vx.i & 0x007FFFFF) | 0x3f000000 };
+  float y = vx.i;
+  y *= 1.1920928955078125e-7f;
+  
+  return y - 124.22551499f
+           - 1.498030302f * mx.f 
+           - 1.72587999f / (0.3520887068f + mx.f);
+}
+
+static FAST_INLINE void fastpow2_loop (const value * in, value * out, unsigned int n) {
+  for (unsigned int k=0; k<n; ++k) {
+    out[k] = fastpow2_inline( in[k] );
+  }
+}
+
+static FAST_INLINE void fastexp_loop (const value * in, value * out, unsigned int n) {
+  for (unsigned int k=0; k<n; ++k) {
+    out[k] = fastpow2_inline( 1.442695040f * (float) in[k] );
+  }
+}
+
+static FAST_INLINE void fastlog2_loop (const value * in, value * out, unsigned int n) {
+  for (unsigned int k=0; k<n; ++k) {
+    out[k] = fastlog2_inline( in[k] );
+  }
+}
+
+static FAST_INLINE void fastlog_loop (const value * in, value * out, unsigned int n) {
+  for (unsigned int k=0; k<n; ++k) {
+    out[k] = 0.69314718f * fastlog2_inline( in[k] );
+  }
+}
+
+typedef void (*fast_batch_fcn) (const value *, value *, unsigned int);
+
+// compiled versions of a loop: avx512f, avx2 and baseline (sse2 on x86-64)
+#ifdef FAST_DISPATCH
+#define FAST_VERSIONS(name) \
+  __attribute__((target("avx512f"))) static void name##_avx512f (const value * in, value * out, unsigned int n) { name##_loop( in, out, n ); } \
+  __attribute__((target("avx2"))) static void name##_avx2 (const value * in, value * out, unsigned int n) { name##_loop( in, out, n ); } \
+  static void name##_base (const value * in, value * out, unsigned int n) { name##_loop( in, out, n ); }
+#define FAST_SELECT(name) select_fast_version( name##_avx512f, name##_avx2, name##_base )
+#else
+#define FAST_VERSIONS(name) \
+  static void name##_base (const value * in, value * out, unsigned int n) { name##_loop( in, out, n ); }
+#define FAST_SELECT(name) name##_base
+#endif
+
+FAST_VERSIONS(fastpow2)
+FAST_VERSIONS(fastexp)
+FAST_VERSIONS(fastlog2)
+FAST_VERSIONS(fastlog)
+
+#ifdef FAST_DISPATCH
+static fast_batch_fcn select_fast_version( fast_batch_fcn avx512f, 
+  fast_batch_fcn avx2, fast_batch_fcn base ) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) { return avx512f; }
+  if (__builtin_cpu_supports("avx2")) { return avx2; }
+  return base;
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+// the version is selected once, on the first call
+void fastpow2_n (const value * in, value * out, unsigned int n) {
+  static const fast_batch_fcn fcn = FAST_SELECT(fastpow2);
+  fcn( in, out, n );
+}
+
+void fastexp_n (const value * in, value * out, unsigned int n) {
+  static const fast_batch_fcn fcn = FAST_SELECT(fastexp);
+  fcn( in, out, n );
+}
+
+void fastlog2_n (const value * in, value * out, unsigned int n) {
+  static const fast_batch_fcn fcn = FAST_SELECT(fastlog2);
+  fcn( in, out, n );
+}
+
+void fastlog_n (const value * in, value * out, unsigned int n) {
+  static const fast_batch_fcn fcn = FAST_SELECT(fastlog);
+  fcn( in, out, n );
+}
+
 value circular_difference(value a, value b) {
     value tmp = (b-a);
     if (tmp<0) {tmp=-tmp;}
@@ -66,6 +194,26 @@ size_t hash_combine( size_t lhs, size_t rhs ) {
     lhs^= rhs + 0x9e3779b9 + (lhs<<6) + (lhs>>2);
     return lhs;
 }
+
+uint64_t hash_bytes( const void * data, size_t n, uint64_t seed ) {
+    
+    const uint64_t prime = 1099511628211ULL;
+    const unsigned char * bytes = static_cast<const unsigned char *>( data );
+    
+    uint64_t h = seed;
+    uint64_t word;
+    
+    for (; n>=sizeof(word); n-=sizeof(word), bytes+=sizeof(word)) {
+        std::memcpy( &word, bytes, sizeof(word) );
+        h = (h ^ word) * prime;
+    }
+    
+    for (; n>0; --n, ++bytes) {
+        h = (h ^ *bytes) * prime;
+    }
+    
+    return h;
+}
     
     
 void multiply_add_vectors( const std::vector<std::vector<value>> & v, unsigned int N, value weight, value * result ) {
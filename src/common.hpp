@@ -21,6 +21,8 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <cstddef>
 
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
@@ -39,11 +41,22 @@ float fastexp (float p);
 float fastlog2 (float x);
 float fastlog (float x);
 
+// batch versions of fast approximations (in and out may be the same array)
+void fastpow2_n (const value * in, value * out, unsigned int n);
+void fastexp_n (const value * in, value * out, unsigned int n);
+void fastlog2_n (const value * in, value * out, unsigned int n);
+void fastlog_n (const value * in, value * out, unsigned int n);
+
 
 value circular_difference(value a, value b);
 
 size_t hash_combine( size_t lhs, size_t rhs );
 
+// stable 64-bit hash (FNV-1a over 8-byte words) of raw data, for 
+// fingerprints that are persisted and compared across runs
+static const uint64_t HASH_SEED = 14695981039346656037ULL;
+uint64_t hash_bytes( const void * data, size_t n, uint64_t seed = HASH_SEED );
+
 void multiply_add_vectors( const std::vector<std::vector<value>> & v, unsigned int N, value weight, value * result );
 void multiply_add_vectors( const std::vector<std::vector<value>> & v, unsigned int N, value weight, value * result, const std::vector<bool> & valid );
 void add_assign_vectors( const std::vector<std::vector<value>> & v, unsigned int N, value weight, value * result );
@@ -18,6 +18,8 @@
 // ---------------------------------------------------------------------
 #include "component.hpp"
 
+#include <algorithm>
+
 YAML::Node Component::to_yaml() const {
     YAML::Node node;
     node["loc"] = location;
@@ -62,6 +64,195 @@ std::unique_ptr<Component> Component::from_hdf5(const HighFive::Group & group) {
     return k;
 }
 
+// constructor
+ComponentStore::ComponentStore( unsigned int ndim, unsigned int nbw ) :
+ndim_(ndim), nbw_(nbw), size_(0) {}
+
+// properties
+std::vector<value> ComponentStore::locations() const {
+    std::vector<value> result;
+    result.reserve( size_*ndim_ );
+    for (auto & b : blocks_) {
+        result.insert( result.end(), b->location_data(), 
+            b->location_data() + b->scale_factors.size()*ndim_ );
+    }
+    return result;
+}
+
+std::vector<value> ComponentStore::bandwidths() const {
+    std::vector<value> result;
+    result.reserve( size_*nbw_ );
+    for (auto & b : blocks_) {
+        result.insert( result.end(), b->bandwidth_data(), 
+            b->bandwidth_data() + b->scale_factors.size()*nbw_ );
+    }
+    return result;
+}
+
+std::vector<value> ComponentStore::scale_factors() const {
+    std::vector<value> result;
+    result.reserve( size_ );
+    for (auto & b : blocks_) {
+        result.insert( result.end(), b->scale_factors.begin(), b->scale_factors.end() );
+    }
+    return result;
+}
+
+value * ComponentStore::mutable_location( unsigned int k ) {
+    return mutable_block_(k).locations.data() + (k%COMPONENT_BLOCK_SIZE)*ndim_;
+}
+
+value * ComponentStore::mutable_bandwidth( unsigned int k ) {
+    return mutable_block_(k).bandwidths.data() + (k%COMPONENT_BLOCK_SIZE)*nbw_;
+}
+
+ComponentStore::Block & ComponentStore::mutable_block_( unsigned int k ) {
+    auto & block = blocks_[k/COMPONENT_BLOCK_SIZE];
+    
+    if (block->owner) {
+        
+        auto copy = std::make_shared<Block>();
+        unsigned int n = block->scale_factors.size();
+        
+        copy->locations.reserve( COMPONENT_BLOCK_SIZE*ndim_ );
+        copy->bandwidths.reserve( COMPONENT_BLOCK_SIZE*nbw_ );
+        copy->locations.assign( block->location_data(), block->location_data() + n*ndim_ );
+        copy->bandwidths.assign( block->bandwidth_data(), block->bandwidth_data() + n*nbw_ );
+        copy->inverse_bandwidths = block->inverse_bandwidths;
+        copy->scale_factors = block->scale_factors;
+        
+        block = copy;
+        
+    } else if (block.use_count()>1) {
+        block = std::make_shared<Block>( *block );
+    }
+    
+    return *block;
+}
+
+// methods
+void ComponentStore::clear() {
+    blocks_.clear();
+    size_ = 0;
+}
+
+void ComponentStore::reserve( unsigned int n ) {
+    blocks_.reserve( (n + COMPONENT_BLOCK_SIZE - 1) / COMPONENT_BLOCK_SIZE );
+}
+
+void ComponentStore::append( const value * loc, const value * bw, value scale_factor ) {
+    
+    if (size_%COMPONENT_BLOCK_SIZE==0) {
+        auto block = std::make_shared<Block>();
+        block->locations.reserve( COMPONENT_BLOCK_SIZE*ndim_ );
+        block->bandwidths.reserve( COMPONENT_BLOCK_SIZE*nbw_ );
+        block->inverse_bandwidths.reserve( COMPONENT_BLOCK_SIZE*nbw_ );
+        block->scale_factors.reserve( COMPONENT_BLOCK_SIZE );
+        blocks_.push_back( block );
+    }
+    
+    auto & block = mutable_block_( size_ );
+    
+    block.locations.insert( block.locations.end(), loc, loc+ndim_ );
+    block.bandwidths.insert( block.bandwidths.end(), bw, bw+nbw_ );
+    for (unsigned int d=0; d<nbw_; ++d) {
+        block.inverse_bandwidths.push_back( 1./bw[d] );
+    }
+    block.scale_factors.push_back( scale_factor );
+    
+    ++size_;
+}
+
+void ComponentStore::assign_external( unsigned int n, const value * loc, 
+    const value * bw, const std::vector<value> & scale_factors, 
+    std::shared_ptr<const void> owner ) {
+    
+    if (scale_factors.size()!=n) {
+        throw std::runtime_error("Number of scale factors does not match number of components.");
+    }
+    
+    clear();
+    reserve( n );
+    
+    for (unsigned int k0=0; k0<n; k0+=COMPONENT_BLOCK_SIZE) {
+        
+        unsigned int nk = std::min( COMPONENT_BLOCK_SIZE, n-k0 );
+        
+        auto block = std::make_shared<Block>();
+        block->external_locations = loc + k0*ndim_;
+        block->external_bandwidths = bw + k0*nbw_;
+        block->owner = owner;
+        
+        block->inverse_bandwidths.resize( nk*nbw_ );
+        for (unsigned int d=0; d<nk*nbw_; ++d) {
+            block->inverse_bandwidths[d] = 1./block->external_bandwidths[d];
+        }
+        
+        block->scale_factors.assign( scale_factors.begin() + k0, 
+            scale_factors.begin() + k0 + nk );
+        
+        blocks_.push_back( block );
+    }
+    
+    size_ = n;
+}
+
+bool ComponentStore::external() const {
+    return std::any_of( blocks_.begin(), blocks_.end(), 
+        []( const std::shared_ptr<Block> & b ) { return static_cast<bool>(b->owner); } );
+}
+
+void ComponentStore::append( const Component & c ) {
+    if (c.location.size()!=ndim_ || c.bandwidth.size()!=nbw_) {
+        throw std::runtime_error("Component vector sizes do not match space.");
+    }
+    append( c.location.data(), c.bandwidth.data(), c.scale_factor );
+}
+
+void ComponentStore::update( unsigned int k, value scale_factor ) {
+    auto & block = mutable_block_(k);
+    unsigned int offset = (k%COMPONENT_BLOCK_SIZE)*nbw_;
+    const value * bw = block.bandwidths.data() + offset;
+    value * inv = block.inverse_bandwidths.data() + offset;
+    for (unsigned int d=0; d<nbw_; ++d) {
+        inv[d] = 1./bw[d];
+    }
+    block.scale_factors[k%COMPONENT_BLOCK_SIZE] = scale_factor;
+}
+
+void ComponentStore::remove( const std::vector<unsigned int> & indices ) {
+    
+    if (indices.empty()) { return; }
+    
+    // components are copied into new blocks, since removal shifts all 
+    // components after the first removed one
+    ComponentStore result( ndim_, nbw_ );
+    result.reserve( size_ - indices.size() );
+    
+    auto next = indices.cbegin();
+    
+    for (unsigned int k=0; k<size_; ++k) {
+        
+        if (next!=indices.cend() && *next==k) {
+            ++next;
+            continue;
+        }
+        
+        result.append( location(k), bandwidth(k), scale_factor(k) );
+    }
+    
+    *this = std::move( result );
+}
+
+Component ComponentStore::component( unsigned int k ) const {
+    Component c;
+    c.location.assign( location(k), location(k)+ndim_ );
+    c.bandwidth.assign( bandwidth(k), bandwidth(k)+nbw_ );
+    c.scale_factor = scale_factor(k);
+    c.scale_factor_log = std::log( c.scale_factor );
+    return c;
+}
+
 
 std::vector<std::unique_ptr<Component>> components_from_flatbuffers(
     const fb_serialize::Kernels * kernels
@@ -32,6 +32,7 @@
 #include "schema_generated.h"
 
 #include <vector>
+#include <memory>
 
 struct Component {
     
@@ -48,6 +49,119 @@ struct Component {
     static std::unique_ptr<Component> from_hdf5(const HighFive::Group & group);
 };
 
+// number of components per block in ComponentStore
+static const unsigned int COMPONENT_BLOCK_SIZE = 256;
+
+// structure-of-arrays storage of mixture components, in blocks of 
+// COMPONENT_BLOCK_SIZE components. Within a block, locations are stored as 
+// [B x ndim] array, bandwidths as [B x nbw] array. Blocks are shared between 
+// copies of the store and are copied on write, such that a copy of the store 
+// (e.g. a snapshot for precomputation) is cheap and only modified blocks are 
+// duplicated. Locations and bandwidths may also refer to external memory 
+// (e.g. a memory-mapped file), in which case blocks are copied into owned
+// storage when they are modified.
+class ComponentStore {
+public:
+    // constructor
+    ComponentStore( unsigned int ndim = 0, unsigned int nbw = 0 );
+    
+    // properties
+    unsigned int ndim() const { return ndim_; }
+    unsigned int nbw() const { return nbw_; }
+    unsigned int size() const { return size_; }
+    bool empty() const { return size_==0; }
+    
+    // contiguous copies of [K x ndim] locations, [K x nbw] bandwidths
+    // and [K] scale factors
+    std::vector<value> locations() const;
+    std::vector<value> bandwidths() const;
+    std::vector<value> scale_factors() const;
+    
+    const value * location( unsigned int k ) const { 
+        return block_(k).location_data() + (k%COMPONENT_BLOCK_SIZE)*ndim_;
+    }
+    const value * bandwidth( unsigned int k ) const { 
+        return block_(k).bandwidth_data() + (k%COMPONENT_BLOCK_SIZE)*nbw_;
+    }
+    const value * inverse_bandwidth( unsigned int k ) const { 
+        return block_(k).inverse_bandwidths.data() + (k%COMPONENT_BLOCK_SIZE)*nbw_;
+    }
+    value scale_factor( unsigned int k ) const { 
+        return block_(k).scale_factors[k%COMPONENT_BLOCK_SIZE];
+    }
+    
+    // blocks of components, for iteration over all components without
+    // indexing every component separately
+    unsigned int nblocks() const { return blocks_.size(); }
+    unsigned int block_size( unsigned int b ) const { return blocks_[b]->scale_factors.size(); }
+    const value * block_locations( unsigned int b ) const { return blocks_[b]->location_data(); }
+    const value * block_bandwidths( unsigned int b ) const { return blocks_[b]->bandwidth_data(); }
+    const value * block_inverse_bandwidths( unsigned int b ) const { return blocks_[b]->inverse_bandwidths.data(); }
+    
+    // location/bandwidth of component k for modification in place,
+    // call update afterwards
+    value * mutable_location( unsigned int k );
+    value * mutable_bandwidth( unsigned int k );
+    
+    // methods
+    void clear();
+    void reserve( unsigned int n );
+    
+    void append( const value * loc, const value * bw, value scale_factor );
+    void append( const Component & c );
+    
+    // replace all components by n components with external [n x ndim] 
+    // locations and [n x nbw] bandwidths, which are not copied and are kept 
+    // alive by owner
+    void assign_external( unsigned int n, const value * loc, const value * bw,
+        const std::vector<value> & scale_factors, std::shared_ptr<const void> owner );
+    
+    // whether any locations/bandwidths refer to external memory
+    bool external() const;
+    
+    // to be called after the bandwidth of component k was changed in place
+    void update( unsigned int k, value scale_factor );
+    
+    // remove components (indices sorted, ascending), order of remaining 
+    // components is preserved
+    void remove( const std::vector<unsigned int> & indices );
+    
+    Component component( unsigned int k ) const;
+    
+protected:
+    struct Block {
+        std::vector<value> locations;
+        std::vector<value> bandwidths;
+        std::vector<value> inverse_bandwidths;
+        std::vector<value> scale_factors;
+        
+        // external locations/bandwidths, used instead of the vectors if set
+        const value * external_locations = nullptr;
+        const value * external_bandwidths = nullptr;
+        std::shared_ptr<const void> owner;
+        
+        const value * location_data() const { 
+            return external_locations ? external_locations : locations.data();
+        }
+        const value * bandwidth_data() const { 
+            return external_bandwidths ? external_bandwidths : bandwidths.data();
+        }
+    };
+    
+    const Block & block_( unsigned int k ) const { 
+        return *blocks_[k/COMPONENT_BLOCK_SIZE];
+    }
+    // block of component k, copied first if it is shared or external
+    Block & mutable_block_( unsigned int k );
+    
+protected:
+    unsigned int ndim_;
+    unsigned int nbw_;
+    unsigned int size_;
+    
+    std::vector<std::shared_ptr<Block>> blocks_;
+};
+
 std::vector<std::unique_ptr<Component>> components_from_flatbuffers(
     const fb_serialize::Kernels * kernels
 );
@@ -18,9 +18,11 @@
 // ---------------------------------------------------------------------
 #include "decoder.hpp"
 
-void compute_posterior(std::vector<value *> result,
-                       std::vector<std::vector<value>> prior,
-                       std::vector<unsigned int> grid_sizes, bool normalize){
+#include <numeric>
+
+void compute_posterior(const std::vector<value *> & result,
+                       const std::vector<std::vector<value>> & prior,
+                       const std::vector<unsigned int> & grid_sizes, bool normalize){
 
     // add log prior
     for (unsigned int index=0; index<result.size(); ++index) {
@@ -40,7 +42,8 @@ void compute_posterior(std::vector<value *> result,
 
         // compute exp( x - max )
         for (unsigned int index=0; index<result.size(); ++index) {
-            std::transform( result[index], result[index] + grid_sizes[index], result[index], [max]( const value & a ) { return fastexp( a - max ); } );
+            std::transform( result[index], result[index] + grid_sizes[index], result[index], [max]( const value & a ) { return a - max; } );
+            fastexp_n( result[index], result[index], grid_sizes[index] );
         }
 
         // compute sum across union
@@ -59,7 +62,7 @@ void compute_posterior(std::vector<value *> result,
 }
 
 void compute_posterior(value * result,
-                       std::vector<value> prior,
+                       const std::vector<value> & prior,
                        unsigned int grid_size, bool normalize){
     // add log prior
     if (prior.size()>0) {
@@ -72,7 +75,8 @@ void compute_posterior(value * result,
         // find maximum
         value max = *std::max_element( result, result + grid_size );
         // compute exp( x - max )
-        std::transform( result, result + grid_size, result, [max]( const value & a ) { return fastexp( a - max ); } );
+        std::transform( result, result + grid_size, result, [max]( const value & a ) { return a - max; } );
+        fastexp_n( result, result, grid_size );
         // compute sum
         value sum = std::accumulate( result, result + grid_size, 0. );
         // divide by sum
@@ -152,33 +156,50 @@ Decoder::Decoder( std::vector<std::vector<std::shared_ptr<PoissonLikelihood>>> &
 }
 
 // decoding methods
+void Decoder::prepare() {
+    
+    for (auto & source : likelihoods_) {
+        for (auto & L : source) {
+            L->prepare();
+        }
+    }
+}
+
+bool Decoder::prepared() const {
+    
+    for (auto & source : likelihoods_) {
+        for (auto & L : source) {
+            if (L->changed()) { return false; }
+        }
+    }
+    
+    return true;
+}
+
 void Decoder::decode( std::vector<value*> events, std::vector<unsigned int> nevents, 
     value delta_t, std::vector<value*> result, bool normalize ) {
     
+    prepare();
+    static_cast<const Decoder&>(*this).decode( events, nevents, delta_t, 
+        result, normalize );
+}
+
+void Decoder::decode( std::vector<value*> events, std::vector<unsigned int> nevents, 
+    value delta_t, std::vector<value*> result, bool normalize ) const {
+    
     // check events and result vectors
     if ( events.size() != nsources() || nevents.size() != nsources() ) {
-        std::runtime_error("Incorrect number of sources.");
+        throw std::runtime_error("Incorrect number of sources.");
     }
     
     if (result.size()!=n_union()) {
-        std::runtime_error("Incorrect number of outputs.");
+        throw std::runtime_error("Incorrect number of outputs.");
     }
     
-    unsigned int n;
-    for (unsigned int source=0; source<nsources(); ++source) {
-        
-        if (!likelihood_selection_[source]) {continue;}
-        
-        // determine number of spikes for source
-        n = nevents[source]/likelihoods_[source][0]->ndim_events();
-        if ( n * likelihoods_[source][0]->ndim_events() != nevents[source] ) {
-            throw std::runtime_error("Incomplete samples.");
-        }
-        
-        for (unsigned int index=0; index<n_union(); ++index) {
-            likelihoods_[source][index]->logL( events[source], n, delta_t, result[index] );
-        }
-    }
+    std::vector<unsigned int> indices(n_union());
+    std::iota( indices.begin(), indices.end(), 0 );
+    
+    accumulate_logL_( events, nevents, delta_t, indices, result );
     
     compute_posterior(result, prior_, grid_sizes_, normalize);
 
@@ -201,9 +222,17 @@ void Decoder::decode ( std::vector<std::vector<value>> events, value delta_t,
 
 void Decoder::decode( std::vector<value*> events, std::vector<unsigned int> nevents, 
     value delta_t, value* result, unsigned int index, bool normalize ) {
+    
+    prepare();
+    static_cast<const Decoder&>(*this).decode( events, nevents, delta_t, 
+        result, index, normalize );
+}
+
+void Decoder::decode( std::vector<value*> events, std::vector<unsigned int> nevents, 
+    value delta_t, value* result, unsigned int index, bool normalize ) const {
 
     if ( events.size() != nsources() || nevents.size() != nsources() ) {
-        std::runtime_error("Incorrect number of sources.");
+        throw std::runtime_error("Incorrect number of sources.");
     }
     
     // only for selected part of union
@@ -211,22 +240,24 @@ void Decoder::decode( std::vector<value*> events, std::vector<unsigned int> neve
         throw std::runtime_error("Union index out of bounds.");
     }
     
-    unsigned int n;
+    // sum log likelihoods
+    accumulate_logL_( events, nevents, delta_t, {index}, {result} );
     
-    for (unsigned int source=0; source<nsources(); ++source) {
-        
-        if (!likelihood_selection_[source]) {continue;}
-        
-        n = nevents[source]/likelihoods_[source][0]->ndim_events();
-        if ( n * likelihoods_[source][0]->ndim_events() != nevents[source] ) {
-            throw std::runtime_error("Incomplete samples.");
-        }
-        
-        // sum log likelihoods
-        likelihoods_[source][index]->logL( events[source], n, delta_t, result );
+    compute_posterior(result, prior_[index], grid_sizes_[index], normalize);
+}
+
+void Decoder::logL( std::vector<value*> events, std::vector<unsigned int> nevents, 
+    value delta_t, value* result, unsigned int index ) const {
+    
+    if ( events.size() != nsources() || nevents.size() != nsources() ) {
+        throw std::runtime_error("Incorrect number of sources.");
     }
     
-    compute_posterior(result, prior_[index], grid_sizes_[index], normalize);
+    if (index>=n_union()) {
+        throw std::runtime_error("Union index out of bounds.");
+    }
+    
+    accumulate_logL_( events, nevents, delta_t, {index}, {result} );
 }
 
 void Decoder::decode ( std::vector<std::vector<value>> events, value delta_t, 
@@ -244,9 +275,355 @@ void Decoder::decode ( std::vector<std::vector<value>> events, value delta_t,
     
 }
     
+void Decoder::decode_batch( std::vector<value*> events, std::vector<unsigned int> nevents,
+    std::vector<unsigned int*> bins, unsigned int nbins, value delta_t,
+    value* result, unsigned int index, bool normalize ) {
+    
+    prepare();
+    static_cast<const Decoder&>(*this).decode_batch( events, nevents, bins, 
+        nbins, delta_t, result, index, normalize );
+}
+
+void Decoder::decode_batch( std::vector<value*> events, std::vector<unsigned int> nevents,
+    std::vector<unsigned int*> bins, unsigned int nbins, value delta_t,
+    value* result, unsigned int index, bool normalize ) const {
+    
+    if ( events.size() != nsources() || nevents.size() != nsources() || 
+         bins.size() != nsources() ) {
+        throw std::runtime_error("Incorrect number of sources.");
+    }
+    
+    if (index>=n_union()) {
+        throw std::runtime_error("Union index out of bounds.");
+    }
+    
+    unsigned int G = grid_sizes_[index];
+    
+    std::vector<unsigned int> n;
+    std::vector<unsigned int> sources;
+    
+    check_batch_( nevents, bins, nbins, n, sources );
+    
+    // index of first event in current block of bins for each source
+    std::vector<unsigned int> first(nsources(), 0);
+    
+    // accumulation buffers: [thread][bin x grid]
+    std::vector<std::vector<value>> buffers;
+    
+    for (unsigned int b0=0; b0<nbins; b0+=DECODE_BATCH_BLOCK) {
+        
+        unsigned int nb = std::min( DECODE_BATCH_BLOCK, nbins-b0 );
+        
+        accumulate_logL_batch_( events, bins, n, sources, first, b0, nb, 
+            delta_t, index, result + b0*G, buffers );
+    }
+    
+    posterior_batch_( result, nbins, index, normalize );
+}
+
+void Decoder::decode_sliding( std::vector<value*> events, std::vector<unsigned int> nevents,
+    std::vector<unsigned int*> bins, unsigned int nbins, unsigned int window,
+    value delta_t, value* result, unsigned int index, bool normalize ) {
+    
+    prepare();
+    static_cast<const Decoder&>(*this).decode_sliding( events, nevents, bins, 
+        nbins, window, delta_t, result, index, normalize );
+}
+
+void Decoder::decode_sliding( std::vector<value*> events, std::vector<unsigned int> nevents,
+    std::vector<unsigned int*> bins, unsigned int nbins, unsigned int window,
+    value delta_t, value* result, unsigned int index, bool normalize ) const {
+    
+    if ( events.size() != nsources() || nevents.size() != nsources() || 
+         bins.size() != nsources() ) {
+        throw std::runtime_error("Incorrect number of sources.");
+    }
+    
+    if (index>=n_union()) {
+        throw std::runtime_error("Union index out of bounds.");
+    }
+    
+    if (window==0 || window>nbins) {
+        throw std::runtime_error("Window should span at least one and at most all time bins.");
+    }
+    
+    unsigned int G = grid_sizes_[index];
+    
+    std::vector<unsigned int> n;
+    std::vector<unsigned int> sources;
+    
+    check_batch_( nevents, bins, nbins, n, sources );
+    
+    // log likelihoods of the previous window bins followed by a block of 
+    // bins, blocks are at least as large as a window to bound the cost of
+    // carrying over bins from one block to the next
+    unsigned int block = std::max( DECODE_BATCH_BLOCK, window );
+    
+    std::vector<value> bin_logL( (window + block) * G, 0. );
+    std::vector<unsigned int> bin_counts( window + block, 0 );
+    
+    // running sum of log likelihoods and number of events in window
+    std::vector<value> sum( G, 0. );
+    unsigned int count = 0;
+    
+    // log likelihood of a window is the sum of the bin log likelihoods, 
+    // except that the rate term log(delta_t) should be log(window*delta_t)
+    value log_window = std::log( (value) window );
+    
+    std::vector<unsigned int> first(nsources(), 0);
+    std::vector<std::vector<value>> buffers;
+    
+    for (unsigned int b0=0; b0<nbins; b0+=block) {
+        
+        unsigned int nb = std::min( block, nbins-b0 );
+        
+        // count events in each bin of block
+        std::fill( bin_counts.begin() + window, bin_counts.end(), 0 );
+        for (auto & source : sources) {
+            for (unsigned int k=first[source]; k<n[source] && bins[source][k]<b0+nb; ++k) {
+                ++bin_counts[ window + bins[source][k] - b0 ];
+            }
+        }
+        
+        // each event is evaluated once, for the bin it belongs to
+        std::fill( bin_logL.begin() + window*G, bin_logL.end(), 0. );
+        
+        accumulate_logL_batch_( events, bins, n, sources, first, b0, nb, 
+            delta_t, index, bin_logL.data() + window*G, buffers );
+        
+        for (unsigned int b=b0; b<b0+nb; ++b) {
+            
+            // slot of bin b in buffer
+            unsigned int slot = window + b - b0;
+            
+            if (b+1<window) { continue; }
+            
+            // window w spans bins [w, b]
+            unsigned int w = b + 1 - window;
+            
+            if (w % window == 0) {
+                // recompute sum once every window, such that rounding errors
+                // of the running sum do not accumulate
+                std::copy( bin_logL.begin() + (slot+1-window)*G, 
+                    bin_logL.begin() + (slot+2-window)*G, sum.begin() );
+                count = bin_counts[slot+1-window];
+                for (unsigned int k=slot+2-window; k<=slot; ++k) {
+                    std::transform( sum.begin(), sum.end(), bin_logL.begin() + k*G, 
+                        sum.begin(), std::plus<value>() );
+                    count += bin_counts[k];
+                }
+            } else {
+                // add newest bin and remove bin that left the window
+                const value * add = bin_logL.data() + slot*G;
+                const value * remove = bin_logL.data() + (slot-window)*G;
+                for (unsigned int g=0; g<G; ++g) {
+                    sum[g] += add[g] - remove[g];
+                }
+                count += bin_counts[slot] - bin_counts[slot-window];
+            }
+            
+            value constant = count * log_window;
+            std::transform( sum.begin(), sum.end(), result + w*G, 
+                [constant](const value & a) { return a + constant; } );
+        }
+        
+        // keep last window bins for next block
+        if (b0+nb<nbins) {
+            std::copy( bin_logL.begin() + nb*G, bin_logL.begin() + (nb+window)*G, 
+                bin_logL.begin() );
+            std::copy( bin_counts.begin() + nb, bin_counts.begin() + nb + window,
+                bin_counts.begin() );
+        }
+    }
+    
+    posterior_batch_( result, nbins + 1 - window, index, normalize );
+}
+
+void Decoder::check_batch_( const std::vector<unsigned int> & nevents,
+    const std::vector<unsigned int*> & bins, unsigned int nbins,
+    std::vector<unsigned int> & n, std::vector<unsigned int> & sources ) const {
+    
+    // determine number of events for each source and check bin indices
+    n.assign( nsources(), 0 );
+    sources.clear();
+    
+    for (unsigned int source=0; source<nsources(); ++source) {
+        
+        if (!likelihood_selection_[source]) {continue;}
+        
+        n[source] = nevents[source]/likelihoods_[source][0]->ndim_events();
+        if ( n[source] * likelihoods_[source][0]->ndim_events() != nevents[source] ) {
+            throw std::runtime_error("Incomplete samples.");
+        }
+        
+        for (unsigned int k=0; k<n[source]; ++k) {
+            if (bins[source][k]>=nbins || (k>0 && bins[source][k]<bins[source][k-1])) {
+                throw std::runtime_error("Bin indices should be non-decreasing and smaller than number of bins.");
+            }
+        }
+        
+        sources.push_back( source );
+    }
+}
+
+void Decoder::accumulate_logL_batch_( const std::vector<value*> & events, 
+    const std::vector<unsigned int*> & bins, const std::vector<unsigned int> & n,
+    const std::vector<unsigned int> & sources, std::vector<unsigned int> & first,
+    unsigned int b0, unsigned int nb, value delta_t, unsigned int index,
+    value * result, std::vector<std::vector<value>> & buffers ) const {
+    
+    unsigned int G = grid_sizes_[index];
+    
+    std::vector<unsigned int> last( first );
+    
+    for (auto & source : sources) {
+        last[source] = std::lower_bound( bins[source] + first[source], 
+            bins[source] + n[source], b0 + nb ) - bins[source];
+    }
+    
+    auto logL = [&] (unsigned int source, value * out) {
+        const PoissonLikelihood & L = *likelihoods_[source][index];
+        L.logL_batch_prepared( 
+            events[source] + first[source]*likelihoods_[source][0]->ndim_events(),
+            last[source] - first[source], bins[source] + first[source], 
+            b0, nb, delta_t, out );
+    };
+    
+    unsigned int nthreads = pool_ ? std::min( pool_->nthreads(), (unsigned int) sources.size() ) : 1;
+    
+    if (nthreads<2) {
+        for (auto & source : sources) {
+            logL( source, result );
+        }
+    } else {
+        buffers.resize( std::max( (unsigned int) buffers.size(), nthreads ) );
+        
+        // same assignment of sources to threads as in decode
+        pool_->run( [&](unsigned int worker) {
+            if (worker>=nthreads) { return; }
+            auto & buffer = buffers[worker];
+            buffer.assign( nb*G, 0. );
+            for (unsigned int t=worker; t<sources.size(); t+=nthreads) {
+                logL( sources[t], buffer.data() );
+            }
+        });
+        
+        for (unsigned int worker=0; worker<nthreads; ++worker) {
+            std::transform( result, result + nb*G, 
+                buffers[worker].begin(), result, std::plus<value>() );
+        }
+    }
+    
+    std::copy( last.begin(), last.end(), first.begin() );
+}
+
+void Decoder::posterior_batch_( value * result, unsigned int nbins, 
+    unsigned int index, bool normalize ) const {
+    
+    unsigned int G = grid_sizes_[index];
+    
+    // posterior for each bin
+    if (pool_) {
+        pool_->run( [&](unsigned int worker) {
+            for (unsigned int b=worker; b<nbins; b+=pool_->nthreads()) {
+                compute_posterior( result + b*G, prior_[index], G, normalize );
+            }
+        });
+    } else {
+        for (unsigned int b=0; b<nbins; ++b) {
+            compute_posterior( result + b*G, prior_[index], G, normalize );
+        }
+    }
+}
+
+void Decoder::accumulate_logL_( const std::vector<value*> & events, 
+    const std::vector<unsigned int> & nevents, value delta_t, 
+    const std::vector<unsigned int> & indices, 
+    const std::vector<value*> & result ) const {
+    
+    // determine number of events for each source and
+    // collect (source, union member) pairs
+    std::vector<unsigned int> n(nsources(), 0);
+    std::vector<std::pair<unsigned int, unsigned int>> tasks;
+    
+    for (unsigned int source=0; source<nsources(); ++source) {
+        
+        if (!likelihood_selection_[source]) {continue;}
+        
+        n[source] = nevents[source]/likelihoods_[source][0]->ndim_events();
+        if ( n[source] * likelihoods_[source][0]->ndim_events() != nevents[source] ) {
+            throw std::runtime_error("Incomplete samples.");
+        }
+        
+        for (unsigned int k=0; k<indices.size(); ++k) {
+            tasks.push_back( {source, k} );
+        }
+    }
+    
+    // likelihoods are only read, they should have been prepared
+    auto logL = [&] (const std::pair<unsigned int, unsigned int> & task, value * out) {
+        const PoissonLikelihood & L = *likelihoods_[task.first][indices[task.second]];
+        L.logL_prepared( events[task.first], n[task.first], delta_t, out );
+    };
+    
+    if (!pool_ || tasks.size()<2) {
+        for (auto & t : tasks) {
+            logL( t, result[t.second] );
+        }
+        return;
+    }
+    
+    unsigned int nthreads = std::min( pool_->nthreads(), (unsigned int) tasks.size() );
+    
+    // accumulation buffers: [thread][union member][grid]
+    std::vector<std::vector<std::vector<value>>> buffers( nthreads, 
+        std::vector<std::vector<value>>( indices.size() ) );
+    
+    // fixed assignment of tasks to threads
+    pool_->run( [&](unsigned int worker) {
+        
+        if (worker>=nthreads) { return; }
+        
+        for (unsigned int k=0; k<indices.size(); ++k) {
+            buffers[worker][k].assign( grid_sizes_[indices[k]], 0. );
+        }
+        
+        for (unsigned int t=worker; t<tasks.size(); t+=nthreads) {
+            logL( tasks[t], buffers[worker][tasks[t].second].data() );
+        }
+    });
+    
+    // reduction in fixed order
+    for (unsigned int k=0; k<indices.size(); ++k) {
+        for (unsigned int worker=0; worker<nthreads; ++worker) {
+            std::transform( result[k], result[k] + grid_sizes_[indices[k]], 
+                buffers[worker][k].begin(), result[k], std::plus<value>() );
+        }
+    }
+}
+    
 // properties
 unsigned int Decoder::nsources() const { return likelihoods_.size(); }
 
+unsigned int Decoder::nthreads() const { 
+    return pool_ ? pool_->nthreads() : 1;
+}
+
+void Decoder::set_nthreads( unsigned int n ) {
+    
+    if (n==0) {
+        n = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+    
+    if (n==nthreads()) { return; }
+    
+    if (n==1) {
+        pool_.reset();
+    } else {
+        pool_.reset( new ThreadPool(n) );
+    }
+}
+
 unsigned int Decoder::nenabled_sources() const { 
     return std::count(likelihood_selection_.begin(),
         likelihood_selection_.end(), true );
@@ -294,6 +671,15 @@ const Grid & Decoder::grid(unsigned int index) const {
     return likelihoods_[0][index]->grid();
 }
 
+const std::vector<value> & Decoder::prior(unsigned int index) const {
+    
+    if (index>=n_union()) {
+        throw std::runtime_error("Index out of bounds.");
+    }
+    
+    return prior_[index];
+}
+
 std::shared_ptr<StimulusOccupancy> Decoder::stimulus(unsigned int index) {
     if (nsources()==0) {
         throw std::runtime_error("No likelihoods.");
@@ -454,7 +840,8 @@ flatbuffers::Offset<fb_serialize::Decoder> Decoder::to_flatbuffers(flatbuffers::
     return fb_decoder;
 }
 
-std::unique_ptr<Decoder> Decoder::from_flatbuffers(const fb_serialize::Decoder * decoder) {
+std::unique_ptr<Decoder> Decoder::from_flatbuffers(const fb_serialize::Decoder * decoder,
+    std::shared_ptr<const void> owner) {
 
     auto nsources = decoder->nsources();
     auto nunion = decoder->nunion();
@@ -465,7 +852,7 @@ std::unique_ptr<Decoder> Decoder::from_flatbuffers(const fb_serialize::Decoder *
     std::map<uint64_t, std::shared_ptr<StimulusOccupancy>> stim_map;
 
     for (auto k : stimuli) {
-        std::shared_ptr<StimulusOccupancy> stim = StimulusOccupancy::from_flatbuffers(k->value());
+        std::shared_ptr<StimulusOccupancy> stim = StimulusOccupancy::from_flatbuffers(k->value(), owner);
         stim_map[k->key()] = stim;
     }
 
@@ -482,7 +869,7 @@ std::unique_ptr<Decoder> Decoder::from_flatbuffers(const fb_serialize::Decoder *
     auto &lhoods = *decoder->likelihoods();
 
     for (auto k : lhoods) {
-        std::shared_ptr<PoissonLikelihood> L = PoissonLikelihood::from_flatbuffers(k->value(), stim_map[k->stimulus_key()]);
+        std::shared_ptr<PoissonLikelihood> L = PoissonLikelihood::from_flatbuffers(k->value(), stim_map[k->stimulus_key()], owner);
         likelihoods[k->source()][k->union_()] = L;
     }
 
@@ -513,6 +900,24 @@ std::unique_ptr<Decoder> Decoder::from_flatbuffers(const fb_serialize::Decoder *
 }
 
 
+void Decoder::save_to_flatbuffers_file( std::string filename ) const {
+    
+    flatbuffers::FlatBufferBuilder builder(1024);
+    builder.Finish( to_flatbuffers(builder) );
+    
+    save_flatbuffer( builder, filename );
+}
+
+std::unique_ptr<Decoder> Decoder::load_from_flatbuffers_file( std::string filename ) {
+    
+    auto file = std::make_shared<MappedFile>( filename );
+    
+    // the mapping stays alive as long as any component refers to it
+    return Decoder::from_flatbuffers( 
+        file->flatbuffer_root<fb_serialize::Decoder>(), file );
+}
+
+
 // hdf5
 void Decoder::to_hdf5(HighFive::Group & group) const {
     
@@ -20,6 +20,7 @@
 
 #include "common.hpp"
 #include "likelihood.hpp"
+#include "threadpool.hpp"
 #include "schema_generated.h"
 
 #include <memory>
@@ -48,15 +49,18 @@ inline std::vector<std::vector<value>> load_prior_from_file(std::string filename
  * @param result number of unions x grid size
  * @param normalize
  */
-void compute_posterior(std::vector<value *> result,
-                       std::vector<std::vector<value>> prior,
-                       std::vector<unsigned int> grid_sizes, bool normalize);
+void compute_posterior(const std::vector<value *> & result,
+                       const std::vector<std::vector<value>> & prior,
+                       const std::vector<unsigned int> & grid_sizes, bool normalize);
 /**
  * @brief compute_posterior based on likelihood result with 1 stimulus space
  * @param result - grid size
  * @param normalize
  */
-void compute_posterior(value * result, std::vector<value> prior, unsigned int grid_size, bool normalize);
+void compute_posterior(value * result, const std::vector<value> & prior, unsigned int grid_size, bool normalize);
+
+// number of time bins that are processed together in Decoder::decode_batch
+static const unsigned int DECODE_BATCH_BLOCK = 256;
 
 class Decoder {
 public:
@@ -68,6 +72,19 @@ public:
     
     // decoding methods
 
+    /**
+     * @brief precompute all likelihoods that have changed
+     * After prepare, the const decoding methods only read shared state and
+     * can be called concurrently from multiple threads on the same decoder.
+     * The non-const decoding methods call prepare automatically.
+     */
+    void prepare();
+
+    /**
+     * @brief check if all likelihoods are precomputed
+     */
+    bool prepared() const;
+
     /**
      * @brief decode with multiple sources and multiple union
      * @param events  each element of the vector is a pointer to an array of events for one source
@@ -78,6 +95,8 @@ public:
      */
     void decode( std::vector<value*> events, std::vector<unsigned int> nevents,
         value delta_t, std::vector<value*> result, bool normalize=true );
+    void decode( std::vector<value*> events, std::vector<unsigned int> nevents,
+        value delta_t, std::vector<value*> result, bool normalize=true ) const;
 
     /**
      * @brief decode with multiple sources and 1 stimulus space
@@ -90,6 +109,8 @@ public:
      */
     void decode ( std::vector<value*> events, std::vector<unsigned int> nevents,
         value delta_t, value* result, unsigned int index=0, bool normalize=true );
+    void decode ( std::vector<value*> events, std::vector<unsigned int> nevents,
+        value delta_t, value* result, unsigned int index=0, bool normalize=true ) const;
 
     /**
      * @brief decode with multiple sources with multiple stimulus spaces (union) - used to reshape the events dimension from a std::vector to an array before calling
@@ -114,8 +135,74 @@ public:
         value* result, unsigned int index=0, bool normalize=true );
 
 
+    /**
+     * @brief decode multiple time bins with multiple sources and 1 stimulus space
+     * @param events  each element of the vector is a pointer to an array of events for one source
+     * @param nevents each element of the vector contains the number of event values for one source
+     * @param bins each element of the vector is a pointer to an array with the time bin index of each event for one source (non-decreasing)
+     * @param nbins number of time bins
+     * @param delta_t size of the time bins in which events are observed
+     * @param result pre-initialized array of size nbins x grid size
+     * @param index index of the stimulus space
+     * @param normalize
+     */
+    void decode_batch( std::vector<value*> events, std::vector<unsigned int> nevents,
+        std::vector<unsigned int*> bins, unsigned int nbins, value delta_t,
+        value* result, unsigned int index=0, bool normalize=true );
+    void decode_batch( std::vector<value*> events, std::vector<unsigned int> nevents,
+        std::vector<unsigned int*> bins, unsigned int nbins, value delta_t,
+        value* result, unsigned int index=0, bool normalize=true ) const;
+
+    /**
+     * @brief decode overlapping time windows with multiple sources and 1 stimulus space
+     * Window k spans the time bins [k, k+window) and has duration window x delta_t.
+     * The log likelihood of each event is computed once for its time bin and 
+     * window sums are updated with a running sum over bins, such that the
+     * cost does not grow with the overlap of windows.
+     * @param events each element of the vector is a pointer to an array of events for one source
+     * @param nevents each element of the vector contains the number of event values for one source
+     * @param bins each element of the vector is a pointer to an array with the time bin index of each event for one source (non-decreasing)
+     * @param nbins number of time bins
+     * @param window number of time bins in a window
+     * @param delta_t size of the time bins in which events are observed
+     * @param result array of size (nbins - window + 1) x grid size
+     * @param index index of the stimulus space
+     * @param normalize
+     */
+    void decode_sliding( std::vector<value*> events, std::vector<unsigned int> nevents,
+        std::vector<unsigned int*> bins, unsigned int nbins, unsigned int window,
+        value delta_t, value* result, unsigned int index=0, bool normalize=true );
+    void decode_sliding( std::vector<value*> events, std::vector<unsigned int> nevents,
+        std::vector<unsigned int*> bins, unsigned int nbins, unsigned int window,
+        value delta_t, value* result, unsigned int index=0, bool normalize=true ) const;
+
+    /**
+     * @brief sum of log likelihoods of all enabled sources for 1 stimulus space (without prior)
+     * @param events each element of the vector contains the event for one source
+     * @param nevents each element of the vector contains the number of event values for one source
+     * @param delta_t size of the time bin in which events are observed
+     * @param result pre-initialized array of grid size, log likelihoods are added
+     * @param index index of the stimulus space
+     */
+    void logL( std::vector<value*> events, std::vector<unsigned int> nevents,
+        value delta_t, value* result, unsigned int index=0 ) const;
+
     // properties
     unsigned int nsources() const;
+    
+    /**
+     * @brief number of threads used for decoding
+     * With more than one thread, likelihoods of sources and union members
+     * are evaluated in parallel on a persistent thread pool. Each thread
+     * accumulates into its own buffer and buffers are summed in thread order,
+     * so that results are reproducible for a fixed number of threads.
+     * Setting the number of threads to 0 selects the number of hardware threads.
+     * Concurrent decoding calls share the thread pool and are executed one
+     * at a time; use a single thread when decoding from multiple threads.
+     */
+    unsigned int nthreads() const;
+    void set_nthreads( unsigned int n );
+    
     bool is_union() const;
     unsigned int n_union() const;
     unsigned int grid_size(unsigned int index=0) const;
@@ -125,6 +212,7 @@ public:
     const std::vector<std::vector<long unsigned int>> & grid_shapes() const;
     
     const Grid & grid(unsigned int index=0) const;
+    const std::vector<value> & prior(unsigned int index=0) const;
     
     std::shared_ptr<StimulusOccupancy> stimulus(unsigned int index=0);
     
@@ -147,7 +235,13 @@ public:
     
     // flatbuffers
     flatbuffers::Offset<fb_serialize::Decoder> to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const;
-    static std::unique_ptr<Decoder> from_flatbuffers(const fb_serialize::Decoder * decoder);
+    static std::unique_ptr<Decoder> from_flatbuffers(const fb_serialize::Decoder * decoder,
+        std::shared_ptr<const void> owner = nullptr);
+    
+    void save_to_flatbuffers_file( std::string filename ) const;
+    // memory-maps file, event and stimulus distributions refer to the 
+    // mapped data until they are modified
+    static std::unique_ptr<Decoder> load_from_flatbuffers_file( std::string filename );
 
     // hdf5 
     void to_hdf5(HighFive::Group & group) const;
@@ -173,4 +267,32 @@ protected:
     std::vector<std::vector<long unsigned int>> grid_shapes_;
     
     std::vector<bool> likelihood_selection_;
+    
+    // sum log likelihoods of all enabled sources for selected union members
+    // result[k] is the output for union member indices[k]
+    void accumulate_logL_( const std::vector<value*> & events, 
+        const std::vector<unsigned int> & nevents, value delta_t, 
+        const std::vector<unsigned int> & indices, 
+        const std::vector<value*> & result ) const;
+    
+    // check number of events and bin indices of enabled sources for batch 
+    // decoding, n is set to the number of events of each source
+    void check_batch_( const std::vector<unsigned int> & nevents,
+        const std::vector<unsigned int*> & bins, unsigned int nbins,
+        std::vector<unsigned int> & n, std::vector<unsigned int> & sources ) const;
+    
+    // add log likelihoods of enabled sources for bins [b0, b0+nb) to result,
+    // first holds the index of the first event in bin b0 for each source and
+    // is advanced to the first event after the bins
+    void accumulate_logL_batch_( const std::vector<value*> & events, 
+        const std::vector<unsigned int*> & bins, const std::vector<unsigned int> & n,
+        const std::vector<unsigned int> & sources, std::vector<unsigned int> & first,
+        unsigned int b0, unsigned int nb, value delta_t, unsigned int index,
+        value * result, std::vector<std::vector<value>> & buffers ) const;
+    
+    // convert log likelihoods of multiple bins to posteriors in place
+    void posterior_batch_( value * result, unsigned int nbins, unsigned int index,
+        bool normalize ) const;
+    
+    std::unique_ptr<ThreadPool> pool_;
 };
@@ -0,0 +1,121 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "evaluator.hpp"
+#include "space.hpp"
+
+template <class K, unsigned int D>
+static std::shared_ptr<const Evaluator> make_euclidean_evaluator_( 
+    const K & kernel, const unsigned int * loc_index, const unsigned int * bw_index, 
+    unsigned int ndim, unsigned int nbw, value factor, unsigned int n ) {
+    
+    if (n==D) {
+        return std::make_shared<EuclideanEvaluator<K,D>>( kernel, loc_index, 
+            bw_index, ndim, nbw, factor );
+    }
+    
+    if constexpr (D>1) {
+        return make_euclidean_evaluator_<K,D-1>( kernel, loc_index, bw_index, 
+            ndim, nbw, factor, n );
+    }
+    
+    return nullptr;
+}
+
+std::shared_ptr<const Evaluator> make_evaluator( const Space & space, 
+    const std::vector<bool> & selection ) {
+    
+    if (selection.size()!=space.ndim()) {
+        throw std::runtime_error("Incorrect selection.");
+    }
+    
+    // find the single euclidean (sub)space with selected dimensions
+    const EuclideanSpace * euclidean = nullptr;
+    unsigned int loc_offset = 0;
+    unsigned int bw_offset = 0;
+    
+    if (auto multi = dynamic_cast<const MultiSpace*>(&space)) {
+        
+        unsigned int loc = 0;
+        unsigned int bw = 0;
+        
+        for (unsigned int k=0; k<multi->nchildren(); ++k) {
+            
+            auto & child = multi->child(k);
+            
+            if (std::count( selection.begin() + loc, 
+                selection.begin() + loc + child.ndim(), true )>0) {
+                
+                // selection spans multiple subspaces
+                if (euclidean!=nullptr) { return nullptr; }
+                
+                euclidean = dynamic_cast<const EuclideanSpace*>(&child);
+                
+                if (euclidean==nullptr) { return nullptr; }
+                
+                loc_offset = loc;
+                bw_offset = bw;
+            }
+            
+            loc += child.ndim();
+            bw += child.nbw();
+        }
+        
+    } else {
+        euclidean = dynamic_cast<const EuclideanSpace*>(&space);
+    }
+    
+    if (euclidean==nullptr) { return nullptr; }
+    
+    // indices of selected dimensions
+    unsigned int loc_index[MAX_EVALUATOR_DIMENSIONS];
+    unsigned int bw_index[MAX_EVALUATOR_DIMENSIONS];
+    unsigned int n = 0;
+    
+    for (unsigned int d=0; d<euclidean->ndim(); ++d) {
+        if (selection[loc_offset+d]) {
+            if (n==MAX_EVALUATOR_DIMENSIONS) { return nullptr; }
+            loc_index[n] = loc_offset + d;
+            bw_index[n] = bw_offset + d;
+            ++n;
+        }
+    }
+    
+    if (n==0) { return nullptr; }
+    
+    auto & kernel = euclidean->kernel();
+    unsigned int ndim = space.ndim();
+    unsigned int nbw = space.nbw();
+    
+    switch (kernel.type()) {
+        case KernelType::Gaussian:
+            return make_euclidean_evaluator_<GaussianKernel,MAX_EVALUATOR_DIMENSIONS>( 
+                static_cast<const GaussianKernel&>(kernel), loc_index, bw_index, 
+                ndim, nbw, 1., n );
+        case KernelType::Epanechnikov:
+            return make_euclidean_evaluator_<EpanechnikovKernel,MAX_EVALUATOR_DIMENSIONS>( 
+                static_cast<const EpanechnikovKernel&>(kernel), loc_index, bw_index, 
+                ndim, nbw, EPA_KERNEL_FACTOR, n );
+        case KernelType::Box:
+            return make_euclidean_evaluator_<BoxKernel,MAX_EVALUATOR_DIMENSIONS>( 
+                static_cast<const BoxKernel&>(kernel), loc_index, bw_index, 
+                ndim, nbw, BOX_KERNEL_FACTOR, n );
+    }
+    
+    return nullptr;
+}
@@ -0,0 +1,171 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include "common.hpp"
+#include "kernel.hpp"
+
+#include <vector>
+#include <memory>
+
+// forward declarations
+class Space;
+
+// maximum number of dimensions for which evaluators are specialized
+static const unsigned int MAX_EVALUATOR_DIMENSIONS = 8;
+
+// Evaluation of the kernels of components over a selection of dimensions, 
+// without the scale factor. Components are passed as [n x ndim] locations 
+// and [n x nbw] inverse bandwidths (as stored in a ComponentStore block) and 
+// points are indexed in the full space, as in Space::partial_logp.
+class Evaluator {
+public:
+    virtual ~Evaluator() {}
+    
+    // number of selected dimensions
+    virtual unsigned int ndim() const = 0;
+    
+    // copy locations and inverse bandwidths (including the kernel's 
+    // bandwidth factor) of the selected dimensions of n components into 
+    // contiguous [n x ndim] arrays
+    virtual void gather( const value * loc, const value * inv_bw, 
+        unsigned int n, value * gathered_loc, value * gathered_inv_bw ) const = 0;
+    // log probability of n gathered components at a single point
+    virtual void partial_logp_gathered( const value * gathered_loc, 
+        const value * gathered_inv_bw, unsigned int n, const value * point, 
+        value * result ) const = 0;
+    
+    // log probability of a single component at n points (stride apart)
+    virtual void partial_logp( const value * loc, const value * inv_bw, 
+        const value * points, unsigned int n, unsigned int stride, 
+        value * result ) const = 0;
+    // adds weighted probability of a single component at n points 
+    // (stride apart) to result
+    virtual void probability( const value * loc, const value * inv_bw, 
+        const value * points, unsigned int n, unsigned int stride, 
+        value weight, value * result ) const = 0;
+};
+
+// evaluator for selected dimensions that are all part of the same euclidean 
+// space, specialized for kernel type and number of selected dimensions D,
+// such that kernel calls are inlined and loops over dimensions are unrolled
+template <class K, unsigned int D>
+class EuclideanEvaluator : public Evaluator {
+public:
+    // constructor, loc_index/bw_index are the indices of the selected 
+    // dimensions in the locations/bandwidths of a component
+    EuclideanEvaluator( const K & kernel, const unsigned int * loc_index, 
+        const unsigned int * bw_index, unsigned int ndim, unsigned int nbw, 
+        value bandwidth_factor ) : 
+        kernel_(kernel), ndim_(ndim), nbw_(nbw), factor_(1./bandwidth_factor) {
+        
+        std::copy( loc_index, loc_index + D, loc_index_ );
+        std::copy( bw_index, bw_index + D, bw_index_ );
+    }
+    
+    virtual unsigned int ndim() const override { return D; }
+    
+    virtual void gather( const value * loc, const value * inv_bw, 
+        unsigned int n, value * gathered_loc, value * gathered_inv_bw ) const override {
+        
+        for (unsigned int c=0; c<n; ++c) {
+            component_( loc, inv_bw, gathered_loc, gathered_inv_bw );
+            loc += ndim_;
+            inv_bw += nbw_;
+            gathered_loc += D;
+            gathered_inv_bw += D;
+        }
+    }
+    
+    virtual void partial_logp_gathered( const value * gathered_loc, 
+        const value * gathered_inv_bw, unsigned int n, const value * point, 
+        value * result ) const override {
+        
+        value x[D];
+        for (unsigned int d=0; d<D; ++d) { x[d] = point[loc_index_[d]]; }
+        
+        // dense loop over components without indexing of dimensions
+        for (unsigned int c=0; c<n; ++c) {
+            value dsquared = 0.;
+            for (unsigned int d=0; d<D; ++d) {
+                value tmp = (x[d] - gathered_loc[c*D+d]) * gathered_inv_bw[c*D+d];
+                dsquared += tmp*tmp;
+            }
+            result[c] = kernel_.K::log_probability( dsquared );
+        }
+    }
+    
+    virtual void partial_logp( const value * loc, const value * inv_bw, 
+        const value * points, unsigned int n, unsigned int stride, 
+        value * result ) const override {
+        
+        value l[D], s[D];
+        component_( loc, inv_bw, l, s );
+        
+        for (unsigned int k=0; k<n; ++k) {
+            *result++ = kernel_.K::log_probability( distance_( l, s, points ) );
+            points += stride;
+        }
+    }
+    
+    virtual void probability( const value * loc, const value * inv_bw, 
+        const value * points, unsigned int n, unsigned int stride, 
+        value weight, value * result ) const override {
+        
+        value l[D], s[D];
+        component_( loc, inv_bw, l, s );
+        
+        for (unsigned int k=0; k<n; ++k) {
+            *result++ += weight * kernel_.K::probability( distance_( l, s, points ) );
+            points += stride;
+        }
+    }
+    
+protected:
+    // gather location and scaled inverse bandwidth of selected dimensions
+    void component_( const value * loc, const value * inv_bw, 
+        value * l, value * s ) const {
+        for (unsigned int d=0; d<D; ++d) {
+            l[d] = loc[loc_index_[d]];
+            s[d] = inv_bw[bw_index_[d]] * factor_;
+        }
+    }
+    
+    value distance_( const value * l, const value * s, const value * point ) const {
+        value dsquared = 0.;
+        for (unsigned int d=0; d<D; ++d) {
+            value tmp = (point[loc_index_[d]] - l[d]) * s[d];
+            dsquared += tmp*tmp;
+        }
+        return dsquared;
+    }
+    
+protected:
+    K kernel_;
+    unsigned int loc_index_[D];
+    unsigned int bw_index_[D];
+    unsigned int ndim_;
+    unsigned int nbw_;
+    value factor_;
+};
+
+// returns specialized evaluator for selected dimensions of space, or nullptr 
+// if there is no specialization (callers then use the Space methods)
+std::shared_ptr<const Evaluator> make_evaluator( const Space & space, 
+    const std::vector<bool> & selection );
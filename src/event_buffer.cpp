@@ -0,0 +1,102 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "event_buffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// constructor
+EventBuffer::EventBuffer( unsigned int ndim, unsigned int capacity ) :
+ndim_(ndim), capacity_(1), head_(0), tail_(0), dropped_(0) {
+    
+    if (ndim==0 || capacity==0) {
+        throw std::runtime_error("Event dimension and buffer capacity should be larger than 0.");
+    }
+    
+    while (capacity_<capacity) { capacity_ <<= 1; }
+    mask_ = capacity_ - 1;
+    
+    times_.resize( capacity_ );
+    events_.resize( capacity_ * ndim_ );
+}
+
+// properties
+unsigned int EventBuffer::ndim() const { return ndim_; }
+unsigned int EventBuffer::capacity() const { return capacity_; }
+
+unsigned int EventBuffer::size() const {
+    unsigned long tail = tail_.load(std::memory_order_acquire);
+    return head_.load(std::memory_order_acquire) - tail;
+}
+
+unsigned long EventBuffer::dropped() const { 
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+// producer methods
+bool EventBuffer::push( double time, const value * event ) {
+    return push( &time, event, 1 )==1;
+}
+
+unsigned int EventBuffer::push( const double * times, const value * events, unsigned int n ) {
+    
+    unsigned long head = head_.load(std::memory_order_relaxed);
+    unsigned long tail = tail_.load(std::memory_order_acquire);
+    
+    unsigned int nfree = capacity_ - (head - tail);
+    unsigned int npush = std::min( n, nfree );
+    
+    for (unsigned int k=0; k<npush; ++k) {
+        unsigned long slot = (head + k) & mask_;
+        times_[slot] = times[k];
+        std::copy( events + k*ndim_, events + (k+1)*ndim_, events_.begin() + slot*ndim_ );
+    }
+    
+    head_.store( head + npush, std::memory_order_release );
+    
+    if (npush<n) {
+        dropped_.fetch_add( n - npush, std::memory_order_relaxed );
+    }
+    
+    return npush;
+}
+
+// consumer methods
+unsigned int EventBuffer::pop( double * times, value * events, unsigned int n ) {
+    
+    unsigned long tail = tail_.load(std::memory_order_relaxed);
+    unsigned long head = head_.load(std::memory_order_acquire);
+    
+    unsigned int npop = std::min( (unsigned long) n, head - tail );
+    
+    for (unsigned int k=0; k<npop; ++k) {
+        unsigned long slot = (tail + k) & mask_;
+        times[k] = times_[slot];
+        std::copy( events_.begin() + slot*ndim_, events_.begin() + (slot+1)*ndim_,
+            events + k*ndim_ );
+    }
+    
+    tail_.store( tail + npop, std::memory_order_release );
+    
+    return npop;
+}
+
+void EventBuffer::clear() {
+    tail_.store( head_.load(std::memory_order_acquire), std::memory_order_release );
+}
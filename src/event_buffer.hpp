@@ -0,0 +1,67 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+#include <atomic>
+
+// Fixed capacity ring buffer of timestamped events for exchange between a
+// single producer thread and a single consumer thread. Storage is allocated
+// at construction and push/pop do not lock or allocate. Events that do not
+// fit are dropped and counted.
+class EventBuffer {
+public:
+    // constructor, capacity is rounded up to a power of two
+    EventBuffer( unsigned int ndim, unsigned int capacity );
+    
+    EventBuffer( const EventBuffer & ) = delete;
+    EventBuffer & operator=( const EventBuffer & ) = delete;
+    
+    // properties
+    unsigned int ndim() const;
+    unsigned int capacity() const;
+    // number of buffered events (exact only when called from producer or consumer)
+    unsigned int size() const;
+    unsigned long dropped() const;
+    
+    // producer methods, return whether the event was buffered and the
+    // number of events that were buffered, respectively
+    bool push( double time, const value * event );
+    unsigned int push( const double * times, const value * events, unsigned int n );
+    
+    // consumer methods, pop copies up to n events into times and events 
+    // and returns the number of copied events
+    unsigned int pop( double * times, value * events, unsigned int n );
+    void clear();
+    
+protected:
+    unsigned int ndim_;
+    unsigned long capacity_;
+    unsigned long mask_;
+    
+    std::vector<double> times_;
+    std::vector<value> events_;
+    
+    // head is written by producer only, tail by consumer only
+    alignas(64) std::atomic<unsigned long> head_;
+    alignas(64) std::atomic<unsigned long> tail_;
+    alignas(64) std::atomic<unsigned long> dropped_;
+};
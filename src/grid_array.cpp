@@ -72,25 +72,25 @@ ArrayGrid::ArrayGrid( const std::vector<value> & array,
 
 // methods to compute probability
 void ArrayGrid::probability( const CategoricalSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
     // ignore valid vector for categorical variables
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     for (unsigned int n=0; n<array_.size(); ++n) {
         *result++ += weight*space.probability( loc, bw, ptr++ );
     }
 }
 void ArrayGrid::probability( const CircularSpace & space, value weight,
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
     // ignore valid vector for circular variables
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     for (unsigned int n=0; n<array_.size(); ++n) {
         *result++ += weight*space.probability( loc, bw, ptr++ );
     }
 }
 void ArrayGrid::probability( const EncodedSpace & space, value weight,
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
     // ignore valid vector for encoded variables
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     if (ninvalid()>0) {
         auto vptr = valid().cbegin();
         // loop through all grid points
@@ -107,8 +107,8 @@ void ArrayGrid::probability( const EncodedSpace & space, value weight,
     }
 }
 void ArrayGrid::probability( const EuclideanSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
-    value * ptr = array_.data();
+    const value * loc, const value * bw, value * result ) const  {
+    const value * ptr = array_.data();
     
     if (ninvalid()>0) {
         auto vptr = valid().cbegin();
@@ -132,7 +132,7 @@ void ArrayGrid::probability( const EuclideanSpace & space, value weight,
 // methods to compute partial log probability
 void ArrayGrid::partial_logp( const CategoricalSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
     if (*selection) {
         for (auto & k : array_) {
             if (static_cast<unsigned int>(*loc)!=static_cast<unsigned int>(k)) {
@@ -145,9 +145,9 @@ void ArrayGrid::partial_logp( const CategoricalSpace & space,
 }
 void ArrayGrid::partial_logp( const CircularSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
     
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     for (unsigned int k=0; k<array_.size(); ++k) {
         *result++ = factor + space.partial_logp( loc, bw, ptr++, selection );
     }
@@ -156,21 +156,21 @@ void ArrayGrid::partial_logp( const CircularSpace & space,
 }
 void ArrayGrid::partial_logp( const EncodedSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
     
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     for (unsigned int k=0; k<array_.size(); ++k) {
         *result++ = factor + space.partial_logp( loc, bw, ptr++, selection );
     }
 }
 void ArrayGrid::partial_logp( const EuclideanSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
     
     // for each point in grid array
     // compute partial_logp + factor and assign to result
     unsigned int npoints = array_.size() / ndim();
-    value * ptr = array_.data();
+    const value * ptr = array_.data();
     
     for (unsigned int k=0; k<npoints; ++k) {
         *result++ = factor + space.partial_logp(loc,bw,ptr,selection);
@@ -180,7 +180,7 @@ void ArrayGrid::partial_logp( const EuclideanSpace & space,
 }
 void ArrayGrid::partial_logp( const MultiSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
     
     // search for child space that has same specification
     unsigned int index;
@@ -29,30 +29,30 @@ public:
     
     // methods to compute probability
     virtual void probability( const CategoricalSpace & space, value weight, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void probability( const CircularSpace & space, value weight,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void probability( const EncodedSpace & space, value weight,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void probability( const EuclideanSpace & space, value weight,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     
     // methods to compute partial log probability
     virtual void partial_logp( const CategoricalSpace & space, 
         std::vector<bool>::const_iterator selection, value factor,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const CircularSpace & space,
         std::vector<bool>::const_iterator selection, value factor,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const EncodedSpace & space,
         std::vector<bool>::const_iterator selection, value factor,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const EuclideanSpace & space,
         std::vector<bool>::const_iterator selection, value factor,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const MultiSpace & space,
         std::vector<bool>::const_iterator selection, value factor,
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     
     // yaml
     virtual YAML::Node to_yaml_impl() const;
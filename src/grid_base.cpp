@@ -78,27 +78,27 @@ const SpaceSpecification & Grid::specification() const {
 
 // methods to compute probability
 void Grid::probability( const Space & space, value weight, const value * loc, 
-    const value * bw, value * result ) {
+    const value * bw, value * result ) const {
      throw std::runtime_error("Not implemented: Space");
  }
 void Grid::probability( const CategoricalSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
      throw std::runtime_error("Not implemented CategoricalSpace");
  }
 void Grid::probability( const CircularSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
      throw std::runtime_error("Not implemented CircularSpace");
  }
 void Grid::probability( const EncodedSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
      throw std::runtime_error("Not implemented EncodedSpace");
  }
 void Grid::probability( const EuclideanSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
      throw std::runtime_error("Not implemented EuclideanSpace");
 }
 void Grid::probability( const MultiSpace & space, value weight, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     throw std::runtime_error("Not implemented MultiSpace");
 }
     
@@ -108,41 +108,52 @@ void Grid::probability( const MultiSpace & space, value weight,
 // methods to compute partial log probability
 void Grid::partial_logp( const Space & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 void Grid::partial_logp( const CategoricalSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 void Grid::partial_logp( const CircularSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 void Grid::partial_logp( const EncodedSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 void Grid::partial_logp( const EuclideanSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 void Grid::partial_logp( const MultiSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     throw std::runtime_error("Not implemented: Space");
 }
 
+std::vector<unsigned int> Grid::factor_sizes( const Space & space ) const {
+    return {};
+}
+
+void Grid::partial_logp_factors( const Space & space, 
+    std::vector<bool>::const_iterator selection, value factor, 
+    const value * loc, const value * bw, value * result ) const {
+    
+    throw std::runtime_error("Grid is not separable.");
+}
+
 //void Grid::marginal( const Space & space, const Component & k, const std::vector<bool> & selection, value * result ) {}
 
 // yaml
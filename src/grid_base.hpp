@@ -74,39 +74,49 @@ public:
     
     // methods to compute probability
     virtual void probability( const Space & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void probability( const CategoricalSpace & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void probability( const CircularSpace & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void probability( const EncodedSpace & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void probability( const EuclideanSpace & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void probability( const MultiSpace & space, value weight, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     
     //void partial_logp( const Space & space, const Component & k, const std::vector<bool> & selection, value * result );
     
     // methods to compute partial log probability
     virtual void partial_logp( const Space & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void partial_logp( const CategoricalSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void partial_logp( const CircularSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void partial_logp( const EncodedSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void partial_logp( const EuclideanSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
     virtual void partial_logp( const MultiSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result );
+        const value * loc, const value * bw, value * result ) const;
+    
+    // separable grids: the partial log probability is a sum of terms that 
+    // each depend on a single factor (axis) of the grid, factor_sizes returns 
+    // the size of each factor (empty if the grid is not separable in space)
+    virtual std::vector<unsigned int> factor_sizes( const Space & space ) const;
+    // computes the terms of all factors, which are stored consecutively in 
+    // result, factor is added to the terms of the first factor
+    virtual void partial_logp_factors( const Space & space, 
+        std::vector<bool>::const_iterator selection, value factor, 
+        const value * loc, const value * bw, value * result ) const;
     
     //virtual void marginal( const Space & space, const Component & k, const std::vector<bool> & selection, value * result );
     
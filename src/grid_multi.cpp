@@ -128,7 +128,7 @@ const Grid & MultiGrid::subgrid(unsigned int index) {
 }
 
 // method to compute probability
-void MultiGrid::probability( const MultiSpace & space, value weight, const value * loc, const value * bw, value * result ) {
+void MultiGrid::probability( const MultiSpace & space, value weight, const value * loc, const value * bw, value * result ) const {
     if (space.nchildren() != grids_.size()) {
         throw std::runtime_error("Invalid number of grids/spaces.");
     }
@@ -155,7 +155,7 @@ void MultiGrid::probability( const MultiSpace & space, value weight, const value
 
 
 // methods to compute partial log probability
-void MultiGrid::partial_logp( const CategoricalSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) {
+void MultiGrid::partial_logp( const CategoricalSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) const {
     // single grid with compatible space?
     if (grids_.size()!=1 || !(grids_[0]->specification()==space.specification())) {
         throw std::runtime_error("Incompatible space.");
@@ -164,7 +164,7 @@ void MultiGrid::partial_logp( const CategoricalSpace & space, std::vector<bool>:
     grids_[0]->partial_logp( space, selection, factor, loc, bw, result );
     //space.partial_logp( *grids_[0], selection, factor, loc, bw, result );
 }
-void MultiGrid::partial_logp( const CircularSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) {
+void MultiGrid::partial_logp( const CircularSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) const {
     // single grid with compatible space?
     if (grids_.size()!=1 || !(grids_[0]->specification()==space.specification())) {
         throw std::runtime_error("Incompatible space.");
@@ -173,7 +173,7 @@ void MultiGrid::partial_logp( const CircularSpace & space, std::vector<bool>::co
     grids_[0]->partial_logp( space, selection, factor, loc, bw, result );
     //space.partial_logp( *grids_[0], selection, factor, loc, bw, result );
 }
-void MultiGrid::partial_logp( const EncodedSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) {
+void MultiGrid::partial_logp( const EncodedSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) const {
     // single grid with compatible space?
     if (grids_.size()!=1 || !(grids_[0]->specification()==space.specification())) {
         throw std::runtime_error("Incompatible space.");
@@ -182,7 +182,7 @@ void MultiGrid::partial_logp( const EncodedSpace & space, std::vector<bool>::con
     grids_[0]->partial_logp( space, selection, factor, loc, bw, result );
     //space.partial_logp( *grids_[0], selection, factor, loc, bw, result );
 }
-void MultiGrid::partial_logp( const EuclideanSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) {
+void MultiGrid::partial_logp( const EuclideanSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) const {
     // single grid with compatible space?
     if (grids_.size()!=1 || !(grids_[0]->specification()==space.specification())) {
         throw std::runtime_error("Incompatible space.");
@@ -191,7 +191,7 @@ void MultiGrid::partial_logp( const EuclideanSpace & space, std::vector<bool>::c
     grids_[0]->partial_logp( space, selection, factor, loc, bw, result );
     //space.partial_logp( *grids_[0], selection, factor, loc, bw, result );
 }
-void MultiGrid::partial_logp( const MultiSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) {
+void MultiGrid::partial_logp( const MultiSpace & space, std::vector<bool>::const_iterator selection, value factor, const value * loc, const value * bw, value * result ) const {
 
     // loop through all matching subspaces
     // if (std::count( selection, selection+subspace.ndim(), true)>0)
@@ -229,6 +229,63 @@ void MultiGrid::partial_logp( const MultiSpace & space, std::vector<bool>::const
     }
 }
 
+std::vector<unsigned int> MultiGrid::factor_sizes( const Space & space ) const {
+    
+    if (ninvalid()>0) {
+        return {};
+    }
+    
+    if (dynamic_cast<const MultiSpace*>(&space)==nullptr) {
+        // single grid with compatible space
+        if (grids_.size()!=1) { return {}; }
+        return grids_[0]->factor_sizes( space );
+    }
+    
+    std::vector<unsigned int> sizes;
+    for (auto & g : grids_) {
+        sizes.push_back( g->size() );
+    }
+    
+    return sizes;
+}
+
+void MultiGrid::partial_logp_factors( const Space & space, 
+    std::vector<bool>::const_iterator selection, value factor, 
+    const value * loc, const value * bw, value * result ) const {
+    
+    auto multi = dynamic_cast<const MultiSpace*>(&space);
+    
+    if (multi==nullptr) {
+        if (grids_.size()!=1 || !(grids_[0]->specification()==space.specification())) {
+            throw std::runtime_error("Incompatible space.");
+        }
+        grids_[0]->partial_logp_factors( space, selection, factor, loc, bw, result );
+        return;
+    }
+    
+    if (ninvalid()>0) {
+        throw std::runtime_error("Grid is not separable.");
+    }
+    
+    // evaluate subgrids of matching subspaces directly into result
+    unsigned int index = 0;
+    
+    for (unsigned int k=0; k<multi->nchildren(); ++k) {
+        
+        if (std::count( selection, selection+multi->child(k).ndim(), true)>0) {
+            
+            multi->child(k).partial_logp( *grids_[index], selection, 
+                index==0 ? factor : 0., loc, bw, result );
+            result += grids_[index]->size();
+            ++index;
+            
+        }
+        loc += multi->child(k).ndim();
+        bw += multi->child(k).nbw();
+        selection += multi->child(k).ndim();
+        
+    }
+}
 
 // yaml
 YAML::Node MultiGrid::to_yaml_impl() const {
@@ -38,24 +38,30 @@ public:
     
     // method to compute probability
     virtual void probability( const MultiSpace & space, value weight, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     
     // methods to compute partial log probability
     virtual void partial_logp( const CategoricalSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const CircularSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const EncodedSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const EuclideanSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
     virtual void partial_logp( const MultiSpace & space, 
         std::vector<bool>::const_iterator selection, value factor, 
-        const value * loc, const value * bw, value * result ) override;
+        const value * loc, const value * bw, value * result ) const override;
+    
+    // separable in multi space, one factor per subgrid
+    virtual std::vector<unsigned int> factor_sizes( const Space & space ) const override;
+    virtual void partial_logp_factors( const Space & space, 
+        std::vector<bool>::const_iterator selection, value factor, 
+        const value * loc, const value * bw, value * result ) const override;
     
     // yaml
     virtual YAML::Node to_yaml_impl() const;
@@ -40,31 +40,44 @@ VectorGrid::VectorGrid( const std::vector<std::vector<value>> & vectors,
     if (shape().size() != vectors_.size() || ndim()!=vectors_.size()) {
         throw std::runtime_error("Incompatible number of vectors.");
     }
+}
+
+// per-thread scratch space with the same shape as the grid vectors, 
+// so that a grid can be evaluated from multiple threads at once
+static std::vector<std::vector<value>> & scratch_vectors( 
+    const std::vector<std::vector<value>> & vectors ) {
+    
+    thread_local std::vector<std::vector<value>> scratch;
+    
+    scratch.resize( vectors.size() );
+    for (unsigned int k=0; k<vectors.size(); ++k) {
+        scratch[k].resize( vectors[k].size() );
+    }
     
-    ptemp_ = vectors_;
+    return scratch;
 }
 
 // methods to compute probability
 void VectorGrid::probability( const CategoricalSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
     // ignore valid vector for categorical variables
-    value * ptr = vectors_[0].data();
+    const value * ptr = vectors_[0].data();
     for (unsigned int n=0; n<vectors_[0].size(); ++n) {
         *result++ += weight*space.probability( loc, bw, ptr++ );
     }
 }
 void VectorGrid::probability( const CircularSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
     // ignore valid vector for circular variables
-    value * ptr = vectors_[0].data();
+    const value * ptr = vectors_[0].data();
     for (unsigned int n=0; n<vectors_[0].size(); ++n) {
         *result++ += weight*space.probability( loc, bw, ptr++ );
     }
 }
 void VectorGrid::probability( const EncodedSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
 
-    value * ptr = vectors_[0].data();
+    const value * ptr = vectors_[0].data();
     if (ninvalid()>0) {
         auto vptr = valid().cbegin();
         for (unsigned int n=0; n<vectors_[0].size(); ++n) {
@@ -81,22 +94,25 @@ void VectorGrid::probability( const EncodedSpace & space, value weight,
     }
 }
 void VectorGrid::probability( const EuclideanSpace & space, value weight, 
-    const value * loc, const value * bw, value * result )  {
+    const value * loc, const value * bw, value * result ) const  {
+    
+    auto & ptemp = scratch_vectors( vectors_ );
+    
     for (unsigned int k=0; k<vectors_.size(); ++k) {
-        space.probability( loc++, bw++, vectors_[k].data(), vectors_[k].size(), ptemp_[k].data() );
+        space.probability( loc++, bw++, vectors_[k].data(), vectors_[k].size(), ptemp[k].data() );
     }
     
     if (ninvalid()>0) {
-        multiply_add_vectors( ptemp_, size(), weight, result, valid() );
+        multiply_add_vectors( ptemp, size(), weight, result, valid() );
     } else {
-        multiply_add_vectors( ptemp_, size(), weight, result );
+        multiply_add_vectors( ptemp, size(), weight, result );
     }
 }
 
 // methods to compute partial log probability
 void VectorGrid::partial_logp( const CategoricalSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     if (*selection) {
         for (auto & k : vectors_[0]) {
@@ -110,9 +126,9 @@ void VectorGrid::partial_logp( const CategoricalSpace & space,
 }
 void VectorGrid::partial_logp( const CircularSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
-    value * ptr = vectors_[0].data();
+    const value * ptr = vectors_[0].data();
     for (unsigned int k=0; k<vectors_[0].size(); ++k) {
         *result++ = factor + space.partial_logp( loc, bw, ptr++, selection );
     }
@@ -121,9 +137,9 @@ void VectorGrid::partial_logp( const CircularSpace & space,
 }
 void VectorGrid::partial_logp( const EncodedSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
-    value * ptr = vectors_[0].data();
+    const value * ptr = vectors_[0].data();
     if (ninvalid()>0) {
         auto vptr = valid().cbegin();
         for (unsigned int n=0; n<vectors_[0].size(); ++n) {
@@ -141,16 +157,18 @@ void VectorGrid::partial_logp( const EncodedSpace & space,
 }
 void VectorGrid::partial_logp( const EuclideanSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     // for each selected grid vector compute log probability
     // add selected vectors and assign to result
     
+    auto & ptemp = scratch_vectors( vectors_ );
+    
     unsigned int index = 0;
     
     for (unsigned int k=0; k<space.ndim(); ++k) {
         if (*selection++) {
-            space.log_probability( loc, bw, vectors_[index].data(), vectors_[index].size(), ptemp_[index].data() );
+            space.log_probability( loc, bw, vectors_[index].data(), vectors_[index].size(), ptemp[index].data() );
             ++index;
         }
         ++loc;
@@ -158,14 +176,14 @@ void VectorGrid::partial_logp( const EuclideanSpace & space,
     }
     
     if (ninvalid()>0) {
-        add_assign_vectors( ptemp_, size(), factor, result, valid() );
+        add_assign_vectors( ptemp, size(), factor, result, valid() );
     } else {
-        add_assign_vectors( ptemp_, size(), factor, result );
+        add_assign_vectors( ptemp, size(), factor, result );
     }
 }
 void VectorGrid::partial_logp( const MultiSpace & space, 
     std::vector<bool>::const_iterator selection, value factor, 
-    const value * loc, const value * bw, value * result ) {
+    const value * loc, const value * bw, value * result ) const {
     
     // search for child space that has same specification
     unsigned int index;
@@ -183,6 +201,80 @@ void VectorGrid::partial_logp( const MultiSpace & space,
     space.child(index).partial_logp( *this, selection, factor, loc, bw, result );
 }
 
+std::vector<unsigned int> VectorGrid::factor_sizes( const Space & space ) const {
+    
+    if (ninvalid()>0) {
+        return {};
+    }
+    
+    if (auto multi = dynamic_cast<const MultiSpace*>(&space)) {
+        // child space that has same specification
+        for (unsigned int index=0; index<multi->nchildren(); ++index) {
+            if (multi->child(index).specification()==specification()) {
+                return factor_sizes( multi->child(index) );
+            }
+        }
+        return {};
+    }
+    
+    if (dynamic_cast<const EuclideanSpace*>(&space)==nullptr) {
+        return {};
+    }
+    
+    std::vector<unsigned int> sizes;
+    for (auto & v : vectors_) {
+        sizes.push_back( v.size() );
+    }
+    
+    return sizes;
+}
+
+void VectorGrid::partial_logp_factors( const Space & space, 
+    std::vector<bool>::const_iterator selection, value factor, 
+    const value * loc, const value * bw, value * result ) const {
+    
+    if (auto multi = dynamic_cast<const MultiSpace*>(&space)) {
+        
+        // search for child space that has same specification
+        unsigned int index;
+        for (index=0; index<multi->nchildren(); ++index) {
+            if (multi->child(index).specification()==specification()) { break; }
+            selection+=multi->child(index).ndim();
+            loc+=multi->child(index).ndim();
+            bw+=multi->child(index).nbw();
+        }
+        
+        if (index>=multi->nchildren()) {
+            throw std::runtime_error("Incompatible space.");
+        }
+        
+        partial_logp_factors( multi->child(index), selection, factor, loc, bw, result );
+        return;
+    }
+    
+    auto euclidean = dynamic_cast<const EuclideanSpace*>(&space);
+    
+    if (euclidean==nullptr || ninvalid()>0) {
+        throw std::runtime_error("Grid is not separable.");
+    }
+    
+    // log probability of each selected grid vector
+    value * first = result;
+    unsigned int index = 0;
+    
+    for (unsigned int k=0; k<euclidean->ndim(); ++k) {
+        if (*selection++) {
+            euclidean->log_probability( loc, bw, vectors_[index].data(), vectors_[index].size(), result );
+            result += vectors_[index].size();
+            ++index;
+        }
+        ++loc;
+        ++bw;
+    }
+    
+    std::transform( first, first + vectors_[0].size(), first, 
+        [factor](const value & a) { return a + factor; } );
+}
 
 // yaml
 YAML::Node VectorGrid::to_yaml_impl() const {
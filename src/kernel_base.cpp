@@ -50,10 +50,10 @@ Kernel::Kernel( KernelType k ) : type_(k) {}
 KernelType Kernel::type() const { return type_; }
 
 // methods
-value Kernel::scale_factor( unsigned int n, value * bw, bool log ) const {
+value Kernel::scale_factor( unsigned int n, const value * bw, bool log ) const {
     return 1.;
 }
-value Kernel::scale_factor( unsigned int n, value * bw, bool log, 
+value Kernel::scale_factor( unsigned int n, const value * bw, bool log, 
     std::vector<bool>::const_iterator selection ) const {
     return 1;
 }
@@ -51,8 +51,8 @@ public:
     virtual std::string to_string() const { return kerneltype_tostring(type()); }
     
     // methods
-    virtual value scale_factor( unsigned int n, value * bw, bool log ) const;
-    virtual value scale_factor( unsigned int n, value * bw, bool log, std::vector<bool>::const_iterator selection ) const;
+    virtual value scale_factor( unsigned int n, const value * bw, bool log ) const;
+    virtual value scale_factor( unsigned int n, const value * bw, bool log, std::vector<bool>::const_iterator selection ) const;
     
     virtual value probability( unsigned int n, const value * loc, const value * bw, const value * point ) const;
     virtual value probability( value dsquared ) const;
@@ -40,11 +40,11 @@ value box_scale_factor( unsigned ndim, value det, bool log ) {
 BoxKernel::BoxKernel() : KernelBase<BoxKernel>(KernelType::Box) {}
 
 // methods
-value BoxKernel::scale_factor( unsigned int n, value * bw, bool log ) const {
+value BoxKernel::scale_factor( unsigned int n, const value * bw, bool log ) const {
     value det = std::accumulate( bw, bw+n, std::pow(BOX_KERNEL_FACTOR,n), std::multiplies<value>() );
     return box_scale_factor( n, det, log );
 }
-value BoxKernel::scale_factor( unsigned int n, value * bw, bool log, 
+value BoxKernel::scale_factor( unsigned int n, const value * bw, bool log, 
     std::vector<bool>::const_iterator selection ) const {
         
     unsigned int ndim = 0;
@@ -74,11 +74,6 @@ value BoxKernel::probability( unsigned int n, const value * loc,
      
      return 1.;
 }
-value BoxKernel::probability( value dsquared ) const {
-    if (dsquared>=1.) { return 0.; }
-    else { return 1.; }
-}
-
 value BoxKernel::log_probability( unsigned int n, const value * loc, 
     const value * bw, const value * point ) const {
     value tmp, d=0.;
@@ -92,11 +87,6 @@ value BoxKernel::log_probability( unsigned int n, const value * loc,
      
      return 0.;
 }
-value BoxKernel::log_probability( value dsquared ) const {
-    if (dsquared>=1.) { return -std::numeric_limits<value>::infinity();; }
-    else { return 0.; }
-}
-
 value BoxKernel::partial_logp( unsigned int n, const value * loc, 
     const value * bw, const value * point, 
     std::vector<bool>::const_iterator selection) const {
@@ -41,11 +41,11 @@ value epanechnikov_scale_factor( unsigned ndim, value det, bool log ) {
 EpanechnikovKernel::EpanechnikovKernel() : KernelBase<EpanechnikovKernel>(KernelType::Epanechnikov) {}
 
 // methods
-value EpanechnikovKernel::scale_factor(unsigned int n, value * bw, bool log) const {
+value EpanechnikovKernel::scale_factor(unsigned int n, const value * bw, bool log) const {
     value det = std::accumulate( bw, bw+n, std::pow(EPA_KERNEL_FACTOR,n), std::multiplies<value>() );
     return epanechnikov_scale_factor( n, det, log );
 }
-value EpanechnikovKernel::scale_factor( unsigned int n, value * bw, bool log, 
+value EpanechnikovKernel::scale_factor( unsigned int n, const value * bw, bool log, 
     std::vector<bool>::const_iterator selection ) const {
     
     unsigned int ndim = 0;
@@ -75,11 +75,6 @@ value EpanechnikovKernel::probability( unsigned int n, const value * loc,
      
      return (1-d);
 }
-value EpanechnikovKernel::probability( value dsquared ) const {
-    if (dsquared>=1.) { return 0.; }
-    else { return (1-dsquared); }
-}
-
 value EpanechnikovKernel::log_probability( unsigned int n, const value * loc, 
     const value * bw, const value * point ) const {
     value tmp, d=0.;
@@ -93,11 +88,6 @@ value EpanechnikovKernel::log_probability( unsigned int n, const value * loc,
      
      return fastlog(1-d);
 }
-value EpanechnikovKernel::log_probability( value dsquared ) const {
-    if (dsquared>=1.) { return -std::numeric_limits<value>::infinity(); }
-    else { return fastlog(1-dsquared); }
-}
-
 value EpanechnikovKernel::partial_logp( unsigned int n, const value * loc, 
     const value * bw, const value * point, std::vector<bool>::const_iterator selection) const {
     value tmp, d=0.;
@@ -20,6 +20,8 @@
 
 #include "kernel_base.hpp"
 
+#include <limits>
+
 static const double EPA_KERNEL_FACTOR = 2.2138043588613394;
 
 value epanechnikov_scale_factor( unsigned ndim, value det, bool log );
@@ -30,14 +32,20 @@ public:
     EpanechnikovKernel();
     
     // methods
-    virtual value scale_factor( unsigned int n, value * bw, bool log ) const;
-    virtual value scale_factor( unsigned int n, value * bw, bool log, std::vector<bool>::const_iterator selection ) const;
+    virtual value scale_factor( unsigned int n, const value * bw, bool log ) const;
+    virtual value scale_factor( unsigned int n, const value * bw, bool log, std::vector<bool>::const_iterator selection ) const;
     
     virtual value probability( unsigned int n, const value * loc, const value * bw, const value * point ) const;
-    virtual value probability( value dsquared ) const;
+    virtual value probability( value dsquared ) const {
+        if (dsquared>=1.) { return 0.; }
+        else { return (1-dsquared); }
+    }
     
     virtual value log_probability( unsigned int n, const value * loc, const value * bw, const value * point ) const;
-    virtual value log_probability( value dsquared ) const;
+    virtual value log_probability( value dsquared ) const {
+        if (dsquared>=1.) { return -std::numeric_limits<value>::infinity(); }
+        else { return fastlog(1-dsquared); }
+    }
     
     virtual value partial_logp( unsigned int n, const value * loc, const value * bw, const value * point, std::vector<bool>::const_iterator selection) const;
     
@@ -46,11 +46,11 @@ value GaussianKernel::cutoff() const { return cutoff_; }
 void GaussianKernel::set_cutoff( value v ) { cutoff_=v; cutoff_squared_=v*v; }
 
 // methods
-value GaussianKernel::scale_factor( unsigned int n, value * bw, bool log ) const {
+value GaussianKernel::scale_factor( unsigned int n, const value * bw, bool log ) const {
     value det = std::accumulate( bw, bw+n, 1., std::multiplies<value>() );
     return gaussian_scale_factor( n, det, cutoff_, log );
 }
-value GaussianKernel::scale_factor( unsigned int n, value * bw, bool log, 
+value GaussianKernel::scale_factor( unsigned int n, const value * bw, bool log, 
     std::vector<bool>::const_iterator selection ) const {
     unsigned int ndim = 0;
     value det = 1.;
@@ -79,11 +79,6 @@ value GaussianKernel::probability( unsigned int n, const value * loc,
     
     return fastexp( -0.5*d );
 }
-value GaussianKernel::probability( value dsquared ) const {
-    if (dsquared>=cutoff_squared_) { return 0.; }
-    else { return fastexp( -0.5*dsquared ); }
-}
-
 value GaussianKernel::log_probability( unsigned int n, const value * loc, 
     const value * bw, const value * point ) const {
     value tmp, d=0.;
@@ -98,11 +93,6 @@ value GaussianKernel::log_probability( unsigned int n, const value * loc,
     
     return -0.5*d;
 }
-value GaussianKernel::log_probability( value dsquared ) const {
-    if (dsquared>=cutoff_squared_) { return -std::numeric_limits<value>::infinity(); }
-    else { return -0.5*dsquared; }
-}
-
 value GaussianKernel::partial_logp( unsigned int n, const value * loc, 
     const value * bw, const value * point, std::vector<bool>::const_iterator selection) const {
     
@@ -20,6 +20,8 @@
 
 #include "kernel_base.hpp"
 
+#include <limits>
+
 static const double DEFAULT_GAUSSIAN_CUTOFF = 3.;
 
 value gaussian_scale_factor( unsigned int ndim, value det, value cutoff, bool log );
@@ -39,17 +41,23 @@ public:
     }
     
     // methods
-    virtual value scale_factor( unsigned int n, value * bw, bool log ) const;
-    virtual value scale_factor( unsigned int n, value * bw, bool log, 
+    virtual value scale_factor( unsigned int n, const value * bw, bool log ) const;
+    virtual value scale_factor( unsigned int n, const value * bw, bool log, 
         std::vector<bool>::const_iterator selection ) const;
     
     virtual value probability( unsigned int n, const value * loc, 
         const value * bw, const value * point ) const;
-    virtual value probability( value dsquared ) const;
+    virtual value probability( value dsquared ) const {
+        if (dsquared>=cutoff_squared_) { return 0.; }
+        else { return fastexp( -0.5*dsquared ); }
+    }
     
     virtual value log_probability( unsigned int n, const value * loc, 
         const value * bw, const value * point ) const;
-    virtual value log_probability( value dsquared ) const;
+    virtual value log_probability( value dsquared ) const {
+        if (dsquared>=cutoff_squared_) { return -std::numeric_limits<value>::infinity(); }
+        else { return -0.5*dsquared; }
+    }
     
     virtual value partial_logp( unsigned int n, const value * loc, 
         const value * bw, const value * point, 
@@ -20,12 +20,14 @@
 
 // default constructor
 PoissonLikelihood::PoissonLikelihood():
-changed_(true), random_insertion_(true), rate_scale_(1.) {}
+version_(1), changes_version_(0), random_insertion_(true), rate_scale_(1.), 
+    background_precompute_(false), background_running_(false), save_precomputed_(false) {}
 
 // constructors
 PoissonLikelihood::PoissonLikelihood( Space & stimulus_space, Grid & grid, 
     double stimulus_duration, value compression )
-    : changed_(true), random_insertion_(true), rate_scale_(1.) {
+    : version_(1), changes_version_(0), random_insertion_(true), rate_scale_(1.), 
+    background_precompute_(false), background_running_(false), save_precomputed_(false) {
     
     if (!(stimulus_space.specification()==grid.specification())) {
         throw std::runtime_error("Grid does not match stimulus space.");
@@ -37,14 +39,14 @@ PoissonLikelihood::PoissonLikelihood( Space & stimulus_space, Grid & grid,
     
     stimulus_grid_.reset( grid.clone() );
     
-    logp_stimulus_.assign( stimulus_grid_->size(), 0. );
-    event_rate_.assign( stimulus_grid_->size(), 0. );
+    init_state_();
     
 }
 
 PoissonLikelihood::PoissonLikelihood( Space & event_space, Space & stimulus_space, 
     Grid & grid, double stimulus_duration, value compression )
-    : changed_(true), random_insertion_(true), rate_scale_(1.) {
+    : version_(1), changes_version_(0), random_insertion_(true), rate_scale_(1.), 
+    background_precompute_(false), background_running_(false), save_precomputed_(false) {
     
     if (!(stimulus_space.specification()==grid.specification())) {
         throw std::runtime_error("Grid does not match stimulus space.");
@@ -57,13 +59,13 @@ PoissonLikelihood::PoissonLikelihood( Space & event_space, Space & stimulus_spac
         stimulus_duration, compression ) );
     stimulus_grid_.reset( grid.clone() );
     
-    logp_stimulus_.assign( stimulus_grid_->size(), 0. );
-    event_rate_.assign( stimulus_grid_->size(), 0. );
+    init_state_();
 }
 
 PoissonLikelihood::PoissonLikelihood( Space & event_space, 
     std::shared_ptr<StimulusOccupancy> stimulus )
-    : changed_(true), random_insertion_(true), rate_scale_(1.) {
+    : version_(1), changes_version_(0), random_insertion_(true), rate_scale_(1.), 
+    background_precompute_(false), background_running_(false), save_precomputed_(false) {
     
     const Space * ptr = &(stimulus->space());
     
@@ -75,12 +77,12 @@ PoissonLikelihood::PoissonLikelihood( Space & event_space,
     
     stimulus_grid_.reset( stimulus->grid().clone() );
     
-    logp_stimulus_.assign( stimulus_grid_->size(), 0. );
-    event_rate_.assign( stimulus_grid_->size(), 0. );
+    init_state_();
 }
 
 PoissonLikelihood::PoissonLikelihood( std::shared_ptr<StimulusOccupancy> stimulus )
-    : changed_(true), random_insertion_(true), rate_scale_(1.) {
+    : version_(1), changes_version_(0), random_insertion_(true), rate_scale_(1.), 
+    background_precompute_(false), background_running_(false), save_precomputed_(false) {
     
     event_distribution_.reset( new Mixture( stimulus->space(), stimulus->compression() ) );
     
@@ -88,12 +90,19 @@ PoissonLikelihood::PoissonLikelihood( std::shared_ptr<StimulusOccupancy> stimulu
     
     stimulus_grid_.reset( stimulus->grid().clone() );
     
-    logp_stimulus_.assign( stimulus_grid_->size(), 0. );
-    event_rate_.assign( stimulus_grid_->size(), 0. );
+    init_state_();
+}
+
+// destructor
+PoissonLikelihood::~PoissonLikelihood() {
+    // background thread may still use this object
+    if (background_.valid()) { background_.wait(); }
 }
 
 // properties
-bool PoissonLikelihood::changed() const { return changed_; }
+bool PoissonLikelihood::changed() const { 
+    return std::atomic_load( &state_ )->version != version_;
+}
 bool PoissonLikelihood::random_insertion() const { return random_insertion_; }
 void PoissonLikelihood::set_random_insertion(bool val) { random_insertion_ = val; }
 
@@ -103,6 +112,43 @@ void PoissonLikelihood::set_random_insertion(bool val) { random_insertion_ = val
 value PoissonLikelihood::rate_scale() const { return rate_scale_; }
 void PoissonLikelihood::set_rate_scale(value val) { rate_scale_ = val; }
 
+bool PoissonLikelihood::save_precomputed() const { return save_precomputed_; }
+void PoissonLikelihood::set_save_precomputed(bool val) { save_precomputed_ = val; }
+
+bool PoissonLikelihood::background_precompute() const { return background_precompute_; }
+void PoissonLikelihood::set_background_precompute(bool val) {
+    if (!val) { wait_precompute(); }
+    background_precompute_ = val;
+}
+
+unsigned int PoissonLikelihood::max_components() const { 
+    return event_distribution_->max_components();
+}
+void PoissonLikelihood::set_max_components(unsigned int n) {
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    unsigned int ncomponents = event_distribution_->ncomponents();
+    event_distribution_->set_max_components( n );
+    if (event_distribution_->ncomponents()!=ncomponents) { ++version_; }
+}
+
+value PoissonLikelihood::min_weight() const { 
+    return event_distribution_->min_weight();
+}
+void PoissonLikelihood::set_min_weight(value v) {
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    unsigned int ncomponents = event_distribution_->ncomponents();
+    event_distribution_->set_min_weight( v );
+    if (event_distribution_->ncomponents()!=ncomponents) { ++version_; }
+}
+
+unsigned int PoissonLikelihood::nthreads() const { 
+    return event_distribution_->nthreads();
+}
+void PoissonLikelihood::set_nthreads( unsigned int n ) {
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    event_distribution_->set_nthreads( n );
+}
+
 unsigned int PoissonLikelihood::ndim() const { 
     return event_distribution_->space().ndim();
 }
@@ -126,12 +172,12 @@ value PoissonLikelihood::mu() const {
     return event_distribution_->sum_of_weights() / stimulus_distribution_->stimulus_time();
 }
 
-const std::vector<value> & PoissonLikelihood::stimulus_logp() const { 
-    return logp_stimulus_;
+std::vector<value> PoissonLikelihood::stimulus_logp() const { 
+    return std::atomic_load( &state_ )->logp_stimulus;
 }
 
-const std::vector<value> & PoissonLikelihood::event_rate() const { 
-    return event_rate_;
+std::vector<value> PoissonLikelihood::event_rate() const { 
+    return std::atomic_load( &state_ )->event_rate;
 }
 
 //const std::vector<value> & PoissonLikelihood::offset() const { 
@@ -156,16 +202,214 @@ void PoissonLikelihood::add_events( const value * events, unsigned int n,
     
     if (repetitions==0) { return; }
     
-    event_distribution_->merge_samples( events, n, random_insertion_, 
-        static_cast<value>(repetitions) );
+    {
+        std::lock_guard<std::mutex> guard( model_lock_ );
+        event_distribution_->merge_samples( events, n, random_insertion_, 
+            static_cast<value>(repetitions) );
+        ++version_;
+    }
+    
+    if (background_precompute_) { precompute_async(); }
+}
+
+void PoissonLikelihood::merge_likelihood( const PoissonLikelihood & other ) {
+    
+    if (!(*other.stimulus_grid_==*stimulus_grid_)) {
+        throw std::runtime_error("Likelihoods do not have the same grid.");
+    }
+    
+    {
+        std::lock_guard<std::mutex> guard( model_lock_ );
+        event_distribution_->merge_mixture( *other.event_distribution_ );
+        ++version_;
+    }
+    
+    if (background_precompute_) { precompute_async(); }
+}
+
+void PoissonLikelihood::reduce( unsigned int ncomponents ) {
     
-    changed_ = true;
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    unsigned int n = event_distribution_->ncomponents();
+    event_distribution_->reduce( ncomponents );
+    if (event_distribution_->ncomponents()!=n) { ++version_; }
+}
+
+void PoissonLikelihood::reduce_threshold( value threshold ) {
+    
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    unsigned int n = event_distribution_->ncomponents();
+    event_distribution_->reduce_threshold( threshold );
+    if (event_distribution_->ncomponents()!=n) { ++version_; }
 }
 
 void PoissonLikelihood::precompute() { 
     
-    logp_stimulus_.assign( stimulus_grid_->size(), 0. );
-    stimulus_distribution_->prob( logp_stimulus_ );
+    // states are built one after the other, each from the previous one
+    wait_precompute();
+    
+    std::unique_lock<std::mutex> guard( model_lock_ );
+    
+    // the event distribution is copied under the lock, so that events can 
+    // be added concurrently while the state is built
+    std::unique_ptr<Mixture> snapshot( new Mixture( *event_distribution_ ) );
+    unsigned long version = version_;
+    
+    auto previous = std::atomic_load( &state_ );
+    auto changes = event_distribution_->changes();
+    
+    if (previous->version!=changes_version_) { changes.reset = true; }
+    
+    event_distribution_->clear_changes();
+    changes_version_ = version;
+    
+    guard.unlock();
+    
+    publish_state_( build_state_( *snapshot, version, changes, previous ) );
+}
+
+void PoissonLikelihood::precompute_async() {
+    
+    std::lock_guard<std::mutex> guard( model_lock_ );
+    
+    // a running background build picks up the changes when it finishes
+    if (background_running_) { return; }
+    
+    // rethrow error of previous run
+    if (background_.valid()) { background_.get(); }
+    
+    background_running_ = true;
+    
+    background_ = std::async( std::launch::async, [this] { background_loop_(); } );
+}
+
+void PoissonLikelihood::background_loop_() {
+    
+    std::unique_lock<std::mutex> guard( model_lock_ );
+    
+    try {
+        
+        // build states until the event distribution has no unpublished changes
+        do {
+            
+            // the event distribution is copied under the lock, so that it can
+            // be modified while the state is built
+            std::shared_ptr<Mixture> snapshot( new Mixture( *event_distribution_ ) );
+            unsigned long version = version_;
+            
+            // own thread pool, such that background builds do not wait for
+            // foreground work on the pool of the event distribution
+            unsigned int nthreads = event_distribution_->nthreads();
+            if (nthreads<2) {
+                background_pool_.reset();
+            } else if (!background_pool_ || background_pool_->nthreads()!=nthreads) {
+                background_pool_.reset( new ThreadPool( nthreads ) );
+            }
+            snapshot->set_thread_pool( background_pool_ );
+            
+            auto previous = std::atomic_load( &state_ );
+            auto changes = event_distribution_->changes();
+            
+            if (previous->version!=changes_version_) { changes.reset = true; }
+            
+            event_distribution_->clear_changes();
+            changes_version_ = version;
+            
+            guard.unlock();
+            publish_state_( build_state_( *snapshot, version, changes, previous ) );
+            guard.lock();
+            
+        } while (std::atomic_load( &state_ )->version != version_);
+        
+    } catch (...) {
+        if (!guard.owns_lock()) { guard.lock(); }
+        background_running_ = false;
+        throw;
+    }
+    
+    background_running_ = false;
+}
+
+void PoissonLikelihood::wait_precompute() {
+    
+    // the future is taken under the lock, since precompute_async may replace
+    // it concurrently, and waited for without the lock, which the background
+    // build needs
+    std::future<void> background;
+    {
+        std::lock_guard<std::mutex> guard( model_lock_ );
+        background = std::move( background_ );
+    }
+    
+    if (background.valid()) { background.get(); }
+}
+
+void PoissonLikelihood::prepare() {
+    
+    if (!changed()) { return; }
+    
+    if (!background_precompute_) {
+        precompute();
+        return;
+    }
+    
+    // without a previous state, there is nothing to evaluate in the meantime
+    if (!std::atomic_load( &state_ )->p_event) {
+        wait_precompute();
+        if (changed()) { precompute(); }
+        return;
+    }
+    
+    precompute_async();
+}
+
+void PoissonLikelihood::init_state_() {
+    
+    auto state = std::make_shared<State>();
+    
+    state->version = 0;
+    state->fingerprint = 0;
+    state->mu = 0.;
+    state->logp_stimulus.assign( stimulus_grid_->size(), 0. );
+    state->marginal.assign( stimulus_grid_->size(), 0. );
+    state->event_rate.assign( stimulus_grid_->size(), 0. );
+    
+    std::atomic_store( &state_, std::shared_ptr<const State>( state ) );
+}
+
+std::shared_ptr<const PoissonLikelihood::State> PoissonLikelihood::current_state_() const {
+    
+    auto state = std::atomic_load( &state_ );
+    
+    if (!state->p_event) {
+        throw std::runtime_error("Likelihood has not been precomputed, call prepare() first.");
+    }
+    
+    return state;
+}
+
+std::shared_ptr<const PoissonLikelihood::State> PoissonLikelihood::build_state_( 
+    const Mixture & events, unsigned long version, const MixtureChanges & changes, 
+    std::shared_ptr<const State> previous ) const {
+    
+    auto state = std::make_shared<State>();
+    
+    state->version = version;
+    // the fingerprint is taken before the stimulus occupancy is read, such 
+    // that a concurrent update of the stimulus occupancy results in a
+    // fingerprint that does not match (and not in stale saved data)
+    state->fingerprint = fingerprint_( events );
+    state->mu = events.sum_of_weights() / stimulus_distribution_->stimulus_time();
+    
+    auto & logp_stimulus = state->logp_stimulus;
+    auto & marginal = state->marginal;
+    auto & event_rate = state->event_rate;
+    
+    // the stimulus occupancy is shared between likelihoods and caches its
+    // (log) probability on the grid
+    std::vector<value> p_stimulus;
+    stimulus_distribution_->prob( p_stimulus );
+    stimulus_distribution_->logp( logp_stimulus );
     
     //if (rate_offset_>0) {
     //    offset_ = logp_stimulus_;
@@ -173,61 +417,198 @@ void PoissonLikelihood::precompute() {
     //    std::transform( offset_.begin(), offset_.end(), offset_.begin(), [factor](const value & a) { return factor*a; } );
     //}
     
-    p_event_.reset( new PartialMixture( event_distribution_.get(), *stimulus_grid_ ) );
+    bool incremental = previous->p_event && !changes.reset && 
+        previous->p_event->ncomponents()==changes.ncomponents;
     
-    event_rate_.assign(stimulus_grid_->size(), 0.);
-    p_event_->marginal( event_rate_.data() );
+    if (incremental) {
+        // only modified and appended components are evaluated
+        state->p_event.reset( new PartialMixture( *previous->p_event, &events, 
+            *stimulus_grid_, changes ) );
+        marginal = previous->marginal;
+        state->p_event->update_marginal( *previous->p_event, changes, marginal.data() );
+    } else {
+        state->p_event.reset( new PartialMixture( &events, *stimulus_grid_ ) );
+        marginal.assign(stimulus_grid_->size(), 0.);
+        state->p_event->marginal( marginal.data() );
+    }
     
-    std::transform( event_rate_.begin(), event_rate_.end(), logp_stimulus_.begin(), event_rate_.begin(), [](const value & a, const value & b) {return a/b;} );
-    std::transform( logp_stimulus_.begin(), logp_stimulus_.end(), logp_stimulus_.begin(), [](const value & a) { return fastlog(a); } );
+    std::transform( marginal.begin(), marginal.end(), p_stimulus.begin(), std::back_inserter(event_rate), [](const value & a, const value & b) {return a/b;} );
+    
+    return state;
+}
+
+void PoissonLikelihood::publish_state_( std::shared_ptr<const State> state ) {
     
-    changed_ = false;
+    std::lock_guard<std::mutex> guard( publish_lock_ );
     
+    if (std::atomic_load( &state_ )->version <= state->version) {
+        std::atomic_store( &state_, state );
+    }
 }
 
-void PoissonLikelihood::likelihood( value * events, unsigned int n, value delta_t, 
-    value * result ) {
+uint64_t PoissonLikelihood::fingerprint_() const {
+    return fingerprint_( *event_distribution_ );
+}
+
+uint64_t PoissonLikelihood::fingerprint_( const Mixture & events ) const {
     
-    logL( events, n, delta_t, result );
-    std::transform( result, result + stimulus_grid_->size(), result, 
-                    [](const value & a) { return fastexp(a); } );
+    uint64_t stimulus = stimulus_distribution_->fingerprint();
+    return hash_bytes( &stimulus, sizeof(stimulus), events.fingerprint() );
+}
+
+std::shared_ptr<const PoissonLikelihood::State> PoissonLikelihood::saveable_state_() const {
+    
+    if (!save_precomputed_) { return nullptr; }
+    
+    auto state = std::atomic_load( &state_ );
+    
+    if (!state->p_event || state->version!=version_ || 
+        state->p_event->ncomponents()==0) {
+        return nullptr;
+    }
+    
+    return state;
+}
+
+void PoissonLikelihood::restore_state_( std::shared_ptr<State> state ) {
+    
+    unsigned int n = stimulus_grid_->size();
+    
+    if (state->logp_stimulus.size()!=n || state->marginal.size()!=n || 
+        state->event_rate.size()!=n) {
+        throw std::runtime_error("Cannot load precomputed data.");
+    }
+    
+    // subsequent changes are relative to the restored state
+    state->version = version_;
+    event_distribution_->clear_changes();
+    changes_version_ = state->version;
+    
+    std::atomic_store( &state_, std::shared_ptr<const State>( state ) );
+}
+
+void PoissonLikelihood::likelihood( const value * events, unsigned int n, 
+    value delta_t, value * result ) {
+    
+    prepare();
+    likelihood_prepared( events, n, delta_t, result );
+}
+
+void PoissonLikelihood::likelihood_prepared( const value * events, unsigned int n, 
+    value delta_t, value * result ) const {
+    
+    logL_prepared( events, n, delta_t, result );
+    fastexp_n( result, result, stimulus_grid_->size() );
 }
 
-void PoissonLikelihood::logL( value * events, unsigned int n, value delta_t,
+void PoissonLikelihood::logL( const value * events, unsigned int n, value delta_t,
     value * result ) {
     
-    if (changed_) { precompute(); }
+    prepare();
+    logL_prepared( events, n, delta_t, result );
+}
+
+void PoissonLikelihood::logL_prepared( const value * events, unsigned int n, 
+    value delta_t, value * result ) const {
     
-    event_logp( events, n, result );
+    auto state = current_state_();
+    
+    state->p_event->complete_multi( events, n, result );
     
-    value constant =  n*fastlog(delta_t*rate_scale_*mu());
+    value constant =  n*fastlog(delta_t*rate_scale_*state->mu);
     std::transform( result, result + stimulus_grid_->size(), result, 
         [constant](const value & a) { return a + constant; } );
     
     // subtract n*log(p_stimulus_)
-    std::transform( result, result + stimulus_grid_->size(), logp_stimulus_.begin(), 
+    std::transform( result, result + stimulus_grid_->size(), state->logp_stimulus.begin(), 
         result, [n](const value & a, const value & b) { return a - n*b; } );
     
     // subtract delta_t * p_event_stimulus_/p_stimulus_
-    constant = delta_t*rate_scale_*mu();
+    constant = delta_t*rate_scale_*state->mu;
     //value offset = rate_offset_/(rate_scale_*mu());
-    std::transform( result, result + stimulus_grid_->size(), event_rate_.begin(), 
+    std::transform( result, result + stimulus_grid_->size(), state->event_rate.begin(), 
         result, [constant](const value & a, const value & b) { return a - constant*b; } );
     
 }
 
-void PoissonLikelihood::event_prob( value * events, unsigned int n, value * result ) {
+void PoissonLikelihood::logL_batch( const value * events, unsigned int n, 
+    const unsigned int * bins, unsigned int first_bin, unsigned int nbins, 
+    value delta_t, value * result ) {
+    
+    prepare();
+    logL_batch_prepared( events, n, bins, first_bin, nbins, delta_t, result );
+}
+
+void PoissonLikelihood::logL_batch_prepared( const value * events, unsigned int n, 
+    const unsigned int * bins, unsigned int first_bin, unsigned int nbins, 
+    value delta_t, value * result ) const {
+    
+    auto state = current_state_();
+    
+    unsigned int G = stimulus_grid_->size();
+    unsigned int ndim = ndim_events();
+    
+    // add log probability of each event to its time bin
+    std::vector<value> tmp( COMPLETE_EVENT_BLOCK * G );
+    std::vector<unsigned int> counts( nbins, 0 );
+    
+    for (unsigned int k=0; k<n; k+=COMPLETE_EVENT_BLOCK) {
+        
+        unsigned int nb = std::min( COMPLETE_EVENT_BLOCK, n-k );
+        
+        state->p_event->complete_events( events + k*ndim, nb, tmp.data() );
+        
+        for (unsigned int e=0; e<nb; ++e) {
+            
+            unsigned int b = bins[k+e] - first_bin;
+            
+            if (bins[k+e]<first_bin || b>=nbins) {
+                throw std::runtime_error("Bin index out of range.");
+            }
+            
+            ++counts[b];
+            
+            std::transform( tmp.begin() + e*G, tmp.begin() + (e+1)*G, 
+                result + b*G, result + b*G, std::plus<value>() );
+        }
+    }
+    
+    // rate terms are shared by all bins
+    // note: computed as float, like in logL
+    float log_rate = fastlog(delta_t*rate_scale_*state->mu);
+    value rate = delta_t*rate_scale_*state->mu;
+    
+    value * r;
+    
+    for (unsigned int b=0; b<nbins; ++b) {
+        
+        r = result + b*G;
+        
+        value constant = counts[b]*log_rate;
+        value nb = counts[b];
+        
+        for (unsigned int g=0; g<G; ++g) {
+            r[g] = ((r[g] + constant) - nb*state->logp_stimulus[g]) - rate*state->event_rate[g];
+        }
+    }
+}
+
+void PoissonLikelihood::event_prob( const value * events, unsigned int n, 
+    value * result ) const {
     
     event_logp( events, n, result );
-    std::transform( result, result + stimulus_grid_->size(), result, [](const value & a) { return fastexp(a); } );
+    fastexp_n( result, result, stimulus_grid_->size() );
 }
 
-void PoissonLikelihood::event_logp( value * events, unsigned int n, value * result ) {
+void PoissonLikelihood::event_logp( const value * events, unsigned int n, 
+    value * result ) const {
+    
+    auto state = current_state_();
     
     //if (rate_offset_>0) {
     //    p_event_->complete_multi( events, n, result, offset_.data() );
     //} else {
-    p_event_->complete_multi( events, n, result );
+    state->p_event->complete_multi( events, n, result );
     //}
 }
 
@@ -295,8 +676,7 @@ std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_yaml(
     p->event_distribution_ = std::move(event_dist);
     p->stimulus_distribution_ = stimulus;
     p->stimulus_grid_.reset(stimulus->grid().clone());
-    p->logp_stimulus_.assign(p->stimulus_grid_->size(), 0.);
-    p->event_rate_.assign(p->stimulus_grid_->size(), 0.);
+    p->init_state_();
     
     p->rate_scale_ = rate_scale;
     p->random_insertion_ = random_insertion;
@@ -316,6 +696,22 @@ flatbuffers::Offset<fb_serialize::PoissonLikelihood> PoissonLikelihood::to_flatb
         stim = stimulus_distribution_->to_flatbuffers(builder);
     }
 
+    flatbuffers::Offset<fb_serialize::PrecomputedLikelihood> precomputed;
+    auto state = saveable_state_();
+
+    if (state) {
+        auto p_event = state->p_event->to_flatbuffers(builder);
+        precomputed = fb_serialize::CreatePrecomputedLikelihood(
+            builder,
+            state->fingerprint,
+            state->mu,
+            builder.CreateVector(state->logp_stimulus),
+            builder.CreateVector(state->marginal),
+            builder.CreateVector(state->event_rate),
+            p_event
+        );
+    }
+
     fb_serialize::PoissonLikelihoodBuilder likelihood_builder(builder);
 
     likelihood_builder.add_rate_scale(rate_scale_);
@@ -326,17 +722,22 @@ flatbuffers::Offset<fb_serialize::PoissonLikelihood> PoissonLikelihood::to_flatb
         likelihood_builder.add_stimulus_distribution(stim);
     }
 
+    if (state) {
+        likelihood_builder.add_precomputed(precomputed);
+    }
+
     auto fb_lhood = likelihood_builder.Finish();
 
     return fb_lhood;
 }
 
-std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_flatbuffers(const fb_serialize::PoissonLikelihood * likelihood, std::shared_ptr<StimulusOccupancy> stimulus) {
+std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_flatbuffers(const fb_serialize::PoissonLikelihood * likelihood, std::shared_ptr<StimulusOccupancy> stimulus,
+    std::shared_ptr<const void> owner) {
 
     auto rate_scale = likelihood->rate_scale();
     bool random_insertion = likelihood->random_insertion();
 
-    auto event_dist = Mixture::from_flatbuffers(likelihood->event_distribution());
+    auto event_dist = Mixture::from_flatbuffers(likelihood->event_distribution(), owner);
 
     // if stimulus distribution was not saved, it should be passed in as shared_ptr
     if (likelihood->stimulus_distribution()==nullptr) {
@@ -347,7 +748,7 @@ std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_flatbuffers(const fb_
         if (stimulus!=nullptr) {
             throw std::runtime_error("Found both saved stimulus distribution and non-null stimulus argument.");
         }
-        stimulus = StimulusOccupancy::from_flatbuffers(likelihood->stimulus_distribution());
+        stimulus = StimulusOccupancy::from_flatbuffers(likelihood->stimulus_distribution(), owner);
     }
 
     // let create "empty" PoissonLikelihood using protected default constructor
@@ -357,12 +758,37 @@ std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_flatbuffers(const fb_
     p->event_distribution_ = std::move(event_dist);
     p->stimulus_distribution_ = stimulus;
     p->stimulus_grid_.reset(stimulus->grid().clone());
-    p->logp_stimulus_.assign(p->stimulus_grid_->size(), 0.);
-    p->event_rate_.assign(p->stimulus_grid_->size(), 0.);
+    p->init_state_();
 
     p->rate_scale_ = rate_scale;
     p->random_insertion_ = random_insertion;
 
+    // restore precomputed state if it is complete and belongs to the 
+    // loaded model, otherwise the likelihood is precomputed when needed
+    auto precomputed = likelihood->precomputed();
+    
+    if (precomputed) {
+        
+        p->save_precomputed_ = true;
+        
+        if (precomputed->logp_stimulus() && precomputed->marginal() && 
+            precomputed->event_rate() && precomputed->p_event() && 
+            precomputed->fingerprint()==p->fingerprint_()) {
+            
+            auto state = std::make_shared<State>();
+            
+            state->fingerprint = precomputed->fingerprint();
+            state->mu = precomputed->mu();
+            state->logp_stimulus.assign( precomputed->logp_stimulus()->begin(), precomputed->logp_stimulus()->end() );
+            state->marginal.assign( precomputed->marginal()->begin(), precomputed->marginal()->end() );
+            state->event_rate.assign( precomputed->event_rate()->begin(), precomputed->event_rate()->end() );
+            state->p_event = PartialMixture::from_flatbuffers( precomputed->p_event(), 
+                p->event_distribution_.get(), *p->stimulus_grid_ );
+            
+            p->restore_state_( state );
+        }
+    }
+
     return p;
 }
 
@@ -382,6 +808,31 @@ void PoissonLikelihood::to_hdf5(HighFive::Group & group, bool save_stimulus) con
         HighFive::Group stim_dist = group.createGroup("stimulus_distribution");
         stimulus_distribution_->to_hdf5(stim_dist);
     }
+    
+    auto state = saveable_state_();
+    
+    if (state) {
+        
+        HighFive::Group precomputed = group.createGroup("precomputed");
+        
+        HighFive::DataSet ds_fp = precomputed.createDataSet<uint64_t>("fingerprint", HighFive::DataSpace::From(state->fingerprint));
+        ds_fp.write(state->fingerprint);
+        
+        HighFive::DataSet ds_mu = precomputed.createDataSet<value>("mu", HighFive::DataSpace::From(state->mu));
+        ds_mu.write(state->mu);
+        
+        HighFive::DataSet ds_stim = precomputed.createDataSet<value>("logp_stimulus", HighFive::DataSpace::From(state->logp_stimulus));
+        ds_stim.write(state->logp_stimulus);
+        
+        HighFive::DataSet ds_marg = precomputed.createDataSet<value>("marginal", HighFive::DataSpace::From(state->marginal));
+        ds_marg.write(state->marginal);
+        
+        HighFive::DataSet ds_rate = precomputed.createDataSet<value>("event_rate", HighFive::DataSpace::From(state->event_rate));
+        ds_rate.write(state->event_rate);
+        
+        HighFive::Group p_event = precomputed.createGroup("p_event");
+        state->p_event->to_hdf5(p_event);
+    }
 }
 
 std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_hdf5(
@@ -414,11 +865,44 @@ std::unique_ptr<PoissonLikelihood> PoissonLikelihood::from_hdf5(
     p->event_distribution_ = std::move(event_dist);
     p->stimulus_distribution_ = stimulus;
     p->stimulus_grid_.reset(stimulus->grid().clone());
-    p->logp_stimulus_.assign(p->stimulus_grid_->size(), 0.);
-    p->event_rate_.assign(p->stimulus_grid_->size(), 0.);
+    p->init_state_();
     
     p->rate_scale_ = rate_scale;
     p->random_insertion_ = random_insertion;
+
+    // restore precomputed state if it is complete and belongs to the 
+    // loaded model, otherwise the likelihood is precomputed when needed
+    if (group.exist("precomputed")) {
+        
+        p->save_precomputed_ = true;
+        
+        HighFive::Group precomputed = group.getGroup("precomputed");
+        
+        bool complete = true;
+        for (auto & name : {"fingerprint", "mu", "logp_stimulus", "marginal", "event_rate", "p_event"}) {
+            complete = complete && precomputed.exist(name);
+        }
+        
+        uint64_t fingerprint = 0;
+        if (complete) {
+            precomputed.getDataSet("fingerprint").read(fingerprint);
+        }
+        
+        if (complete && fingerprint==p->fingerprint_()) {
+            
+            auto state = std::make_shared<State>();
+            
+            state->fingerprint = fingerprint;
+            precomputed.getDataSet("mu").read(state->mu);
+            precomputed.getDataSet("logp_stimulus").read(state->logp_stimulus);
+            precomputed.getDataSet("marginal").read(state->marginal);
+            precomputed.getDataSet("event_rate").read(state->event_rate);
+            state->p_event = PartialMixture::from_hdf5( precomputed.getGroup("p_event"),
+                p->event_distribution_.get(), *p->stimulus_grid_ );
+            
+            p->restore_state_( state );
+        }
+    }
     
     return p;
 
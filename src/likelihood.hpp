@@ -26,6 +26,9 @@
 #include "schema_generated.h"
 
 #include <memory>
+#include <atomic>
+#include <future>
+#include <mutex>
 
 class PoissonLikelihood {
 protected:
@@ -38,6 +41,9 @@ public:
     PoissonLikelihood( Space & event_space, std::shared_ptr<StimulusOccupancy> stimulus );
     PoissonLikelihood( std::shared_ptr<StimulusOccupancy> stimulus );
     
+    // destructor
+    ~PoissonLikelihood();
+    
     // properties
     bool changed() const;
     bool random_insertion() const;
@@ -49,6 +55,29 @@ public:
     value rate_scale() const;
     void set_rate_scale(value val);
     
+    // if enabled, add_events and prepare rebuild the precomputed state on a
+    // background thread and evaluation keeps using the previous state until
+    // the new state is swapped in
+    bool background_precompute() const;
+    void set_background_precompute(bool val);
+    
+    // if enabled, an up-to-date precomputed state is saved (to flatbuffers 
+    // and hdf5) together with a fingerprint of the model it was built from, 
+    // and is restored when loading if the fingerprint matches the loaded 
+    // model and the saved state is complete
+    bool save_precomputed() const;
+    void set_save_precomputed(bool val);
+    
+    // size bounds of event distribution (see Mixture)
+    unsigned int max_components() const;
+    void set_max_components(unsigned int n);
+    value min_weight() const;
+    void set_min_weight(value v);
+    
+    // worker threads for evaluation of event distribution (see Mixture)
+    unsigned int nthreads() const;
+    void set_nthreads( unsigned int n );
+    
     unsigned int ndim() const;
     unsigned int ndim_stimulus() const;
     unsigned int ndim_events() const;
@@ -59,8 +88,8 @@ public:
     std::shared_ptr<StimulusOccupancy> stimulus();
     value mu() const;
 
-    const std::vector<value> & stimulus_logp() const;
-    const std::vector<value> & event_rate() const;
+    std::vector<value> stimulus_logp() const;
+    std::vector<value> event_rate() const;
 
     //const std::vector<value> & offset() const;
         
@@ -68,12 +97,43 @@ public:
     void add_events( const std::vector<value> & events, unsigned int repetitions = 1 );
     void add_events( const value * events, unsigned int n, unsigned int repetitions = 1 );
     
+    // merge event distribution of other likelihood with the same event space 
+    // and grid, the stimulus occupancy (which may be shared by multiple 
+    // likelihoods) is not merged and should be merged separately
+    void merge_likelihood( const PoissonLikelihood & other );
+    
+    // reduction of event distribution (see Mixture)
+    void reduce( unsigned int ncomponents );
+    void reduce_threshold( value threshold );
+    
     void precompute();
+    // precompute from a snapshot of the event distribution on a background 
+    // thread. If a background precompute is already running, it takes a new
+    // snapshot when it finishes, until all changes are published.
+    void precompute_async();
+    // wait for background precompute to finish
+    void wait_precompute();
+    // precompute if changed
+    void prepare();
 
-    void likelihood( value * events, unsigned int n, value delta_t, value * result );
-    void logL( value * events, unsigned int n, value delta_t, value * result );
-    void event_prob( value * events, unsigned int n, value * result );
-    void event_logp( value * events, unsigned int n, value * result );
+    // evaluation methods call prepare first
+    void likelihood( const value * events, unsigned int n, value delta_t, value * result );
+    void logL( const value * events, unsigned int n, value delta_t, value * result );
+    // log likelihood for multiple time bins, bins[k] is the index of the 
+    // time bin of event k and result [nbins x grid] starts at first_bin
+    void logL_batch( const value * events, unsigned int n, const unsigned int * bins,
+        unsigned int first_bin, unsigned int nbins, value delta_t, value * result );
+    
+    // *_prepared evaluation methods do not call prepare, but use the most 
+    // recent precomputed state and can be called concurrently from multiple 
+    // threads (they throw if the likelihood was never precomputed)
+    void likelihood_prepared( const value * events, unsigned int n, value delta_t, value * result ) const;
+    void logL_prepared( const value * events, unsigned int n, value delta_t, value * result ) const;
+    void logL_batch_prepared( const value * events, unsigned int n, const unsigned int * bins,
+        unsigned int first_bin, unsigned int nbins, value delta_t, value * result ) const;
+    // event probabilities use the most recent precomputed state as well
+    void event_prob( const value * events, unsigned int n, value * result ) const;
+    void event_logp( const value * events, unsigned int n, value * result ) const;
     
     // yaml
     YAML::Node to_yaml( bool save_stimulus=true ) const;
@@ -86,7 +146,8 @@ public:
     
     // flatbuffers
     flatbuffers::Offset<fb_serialize::PoissonLikelihood> to_flatbuffers(flatbuffers::FlatBufferBuilder &builder, bool save_stimulus=true) const;
-    static std::unique_ptr<PoissonLikelihood> from_flatbuffers(const fb_serialize::PoissonLikelihood * likelihood, std::shared_ptr<StimulusOccupancy> stimulus = nullptr);
+    static std::unique_ptr<PoissonLikelihood> from_flatbuffers(const fb_serialize::PoissonLikelihood * likelihood, std::shared_ptr<StimulusOccupancy> stimulus = nullptr,
+        std::shared_ptr<const void> owner = nullptr);
 
     // hdf5
     void to_hdf5(HighFive::Group & group, bool save_stimulus=true) const;
@@ -106,14 +167,61 @@ protected:
     std::shared_ptr<StimulusOccupancy> stimulus_distribution_;
     std::unique_ptr<Grid> stimulus_grid_; // stimulus space
     
-    std::vector<value> logp_stimulus_; // pi(x)
-    std::vector<value> event_rate_; // p(x)
-    std::unique_ptr<PartialMixture> p_event_; // p(a,x) @ x
     //std::vector<value> offset_;
     
-    bool changed_;
+    // precomputed state, which is replaced as a whole
+    struct State {
+        unsigned long version; // version of event distribution
+        uint64_t fingerprint; // fingerprint of the model the state was built from
+        value mu;
+        std::vector<value> logp_stimulus; // pi(x)
+        std::vector<value> marginal; // sum of weighted event components at x
+        std::vector<value> event_rate; // p(x)
+        std::unique_ptr<PartialMixture> p_event; // p(a,x) @ x
+    };
+    
+    // access with std::atomic_load/std::atomic_store
+    std::shared_ptr<const State> state_;
+    // incremented for every change of the event distribution, written under
+    // model_lock_ and read without lock (e.g. by changed())
+    std::atomic<unsigned long> version_;
+    // version at which the tracked changes of the event distribution were cleared
+    std::atomic<unsigned long> changes_version_;
+    
     bool random_insertion_;
     
     //value rate_offset_;
     value rate_scale_;
+    
+    bool background_precompute_;
+    std::atomic<bool> background_running_;
+    std::future<void> background_;
+    std::mutex publish_lock_;
+    // guards event distribution and versions while a background build
+    // takes a snapshot
+    std::mutex model_lock_;
+    std::shared_ptr<ThreadPool> background_pool_;
+    
+    bool save_precomputed_;
+    
+    void init_state_();
+    // current state, throws if likelihood was never precomputed
+    std::shared_ptr<const State> current_state_() const;
+    // builds state incrementally from previous state, if changes of the
+    // event distribution are relative to the previous state
+    std::shared_ptr<const State> build_state_( const Mixture & events, 
+        unsigned long version, const MixtureChanges & changes, 
+        std::shared_ptr<const State> previous ) const;
+    // swap in state, unless it is older than the current state
+    void publish_state_( std::shared_ptr<const State> state );
+    // takes snapshots and builds states on the background thread
+    void background_loop_();
+    
+    // fingerprint of event and stimulus distributions and grid
+    uint64_t fingerprint_() const;
+    uint64_t fingerprint_( const Mixture & events ) const;
+    // state that can be saved (up-to-date and precomputed), or nullptr
+    std::shared_ptr<const State> saveable_state_() const;
+    // makes restored state current, as if it was precomputed
+    void restore_state_( std::shared_ptr<State> state );
 };
@@ -0,0 +1,159 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "mapped_file.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// constructor
+MappedFile::MappedFile( std::string filename ) :
+filename_(filename), data_(nullptr), size_(0) {
+    
+    HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, 
+        FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, 
+        FILE_ATTRIBUTE_NORMAL, nullptr );
+    
+    if (file==INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open file " + filename + ".");
+    }
+    
+    LARGE_INTEGER info;
+    
+    if (!GetFileSizeEx( file, &info ) || info.QuadPart==0) {
+        CloseHandle( file );
+        throw std::runtime_error("Cannot map empty file " + filename + ".");
+    }
+    
+    size_ = static_cast<size_t>( info.QuadPart );
+    
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    
+    // the mapping keeps the file open
+    CloseHandle( file );
+    
+    if (mapping==nullptr) {
+        throw std::runtime_error("Cannot map file " + filename + ".");
+    }
+    
+    void * ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    
+    // the view keeps the mapping alive
+    CloseHandle( mapping );
+    
+    if (ptr==nullptr) {
+        throw std::runtime_error("Cannot map file " + filename + ".");
+    }
+    
+    data_ = static_cast<const uint8_t*>( ptr );
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile( data_ );
+}
+
+// replaces target file by source file
+static bool replace_file( const std::string & source, const std::string & target ) {
+    return MoveFileExA( source.c_str(), target.c_str(), 
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH )!=0;
+}
+
+#else
+
+// constructor
+MappedFile::MappedFile( std::string filename ) :
+filename_(filename), data_(nullptr), size_(0) {
+    
+    int fd = open( filename.c_str(), O_RDONLY );
+    
+    if (fd<0) {
+        throw std::runtime_error("Cannot open file " + filename + ".");
+    }
+    
+    struct stat info;
+    
+    if (fstat( fd, &info )!=0 || info.st_size==0) {
+        close( fd );
+        throw std::runtime_error("Cannot map empty file " + filename + ".");
+    }
+    
+    size_ = info.st_size;
+    
+    void * ptr = mmap( nullptr, size_, PROT_READ, MAP_SHARED, fd, 0 );
+    
+    // the mapping remains valid after the file is closed
+    close( fd );
+    
+    if (ptr==MAP_FAILED) {
+        throw std::runtime_error("Cannot map file " + filename + ".");
+    }
+    
+    data_ = static_cast<const uint8_t*>( ptr );
+}
+
+MappedFile::~MappedFile() {
+    munmap( const_cast<uint8_t*>(data_), size_ );
+}
+
+// replaces target file by source file (atomically)
+static bool replace_file( const std::string & source, const std::string & target ) {
+    return std::rename( source.c_str(), target.c_str() )==0;
+}
+
+#endif
+
+void save_flatbuffer( const flatbuffers::FlatBufferBuilder & builder, std::string filename ) {
+    
+    // the data is written to a temporary file that then replaces the 
+    // target file, so that existing mappings of the target file (possibly 
+    // in other processes) keep seeing the old contents
+    std::string tmp = filename + ".tmp";
+    
+    std::ofstream stream( tmp, std::ios::binary | std::ios::trunc );
+    
+    stream.write( reinterpret_cast<const char*>( builder.GetBufferPointer() ), 
+        builder.GetSize() );
+    stream.close();
+    
+    if (!stream) {
+        std::remove( tmp.c_str() );
+        throw std::runtime_error("Cannot write file " + filename + ".");
+    }
+    
+    if (!replace_file( tmp, filename )) {
+        std::remove( tmp.c_str() );
+        throw std::runtime_error("Cannot replace file " + filename + ".");
+    }
+}
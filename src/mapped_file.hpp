@@ -0,0 +1,65 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include "flatbuffers/flatbuffers.h"
+
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+// Read-only memory mapping of a file. Pages are loaded on demand and are
+// shared between processes that map the same file.
+class MappedFile {
+public:
+    // constructor
+    MappedFile( std::string filename );
+    ~MappedFile();
+    
+    MappedFile( const MappedFile & ) = delete;
+    MappedFile & operator=( const MappedFile & ) = delete;
+    
+    // properties
+    const std::string & filename() const { return filename_; }
+    const uint8_t * data() const { return data_; }
+    size_t size() const { return size_; }
+    
+    // verifies that the file holds a flatbuffer with root table T and 
+    // returns the root table
+    template <typename T>
+    const T * flatbuffer_root() const {
+        
+        flatbuffers::Verifier verifier( data_, size_ );
+        
+        if (!verifier.VerifyBuffer<T>(nullptr)) {
+            throw std::runtime_error("File " + filename_ + " does not contain valid flatbuffers data.");
+        }
+        
+        return flatbuffers::GetRoot<T>( data_ );
+    }
+    
+protected:
+    std::string filename_;
+    const uint8_t * data_;
+    size_t size_;
+};
+
+// writes finished flatbuffer to a temporary file that then replaces the
+// target file, so that existing mappings of the target file are not affected
+void save_flatbuffer( const flatbuffers::FlatBufferBuilder & builder, std::string filename );
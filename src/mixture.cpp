@@ -19,6 +19,10 @@
 #include "mixture.hpp"
 #include <random>
 #include <algorithm>
+#include <numeric>
+#include <limits>
+#include <queue>
+#include <tuple>
 
 #include <iostream>
 
@@ -26,23 +30,33 @@
 Mixture::Mixture( const Space & space, value threshold ) :
 sum_of_weights_(0), sum_of_nsamples_(0),
 threshold_(threshold), threshold_squared_(threshold*threshold),
-space_(space.clone()) {}
+space_(space.clone()), 
+evaluator_(make_evaluator(space, std::vector<bool>(space.ndim(), true))),
+kernels_(space.ndim(), space.nbw()), weight_scale_(1.),
+max_components_(0), min_weight_(0.), 
+min_relative_weight_(std::numeric_limits<value>::infinity()),
+index_(new SpatialIndex(space, threshold)) {}
 
 // copy constructor
 Mixture::Mixture( const Mixture& other ) :
 sum_of_weights_(other.sum_of_weights_), sum_of_nsamples_(other.sum_of_nsamples_),
 threshold_(other.threshold_), threshold_squared_(other.threshold_squared_), 
-space_(other.space_->clone()), weights_(other.weights_) {
-    for (auto & c : other.kernels_ ) {
-        kernels_.emplace_back( new Component( *c ) );
-    }
-}
+space_(other.space_->clone()), evaluator_(other.evaluator_), 
+kernels_(other.kernels_), weights_(other.weights_),
+weight_scale_(other.weight_scale_), max_components_(other.max_components_),
+min_weight_(other.min_weight_), min_relative_weight_(other.min_relative_weight_),
+index_(new SpatialIndex(*other.space_, other.threshold_)), pool_(other.pool_), 
+changes_(other.changes_) {}
 
 void Mixture::clear() {
     sum_of_weights_ = 0;
     sum_of_nsamples_ = 0;
     kernels_.clear();
     weights_.clear();
+    weight_scale_ = 1.;
+    min_relative_weight_ = std::numeric_limits<value>::infinity();
+    index_->clear();
+    changes_.reset = true;
 }
 
 // properties
@@ -50,12 +64,43 @@ value Mixture::sum_of_weights() const { return sum_of_weights_; }
 value Mixture::sum_of_nsamples() const { return sum_of_nsamples_; }
 value Mixture::threshold() const { return threshold_; }
 unsigned int Mixture::ncomponents() const { return kernels_.size(); }
+unsigned int Mixture::max_components() const { return max_components_; }
+
+unsigned int Mixture::nthreads() const { 
+    return pool_ ? pool_->nthreads() : 1;
+}
+
+void Mixture::set_nthreads( unsigned int n ) {
+    
+    if (n==0) {
+        n = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+    
+    if (n==nthreads()) { return; }
+    
+    if (n==1) {
+        pool_.reset();
+    } else {
+        pool_.reset( new ThreadPool(n) );
+    }
+}
+void Mixture::set_thread_pool( std::shared_ptr<ThreadPool> pool ) {
+    pool_ = pool;
+}
+value Mixture::min_weight() const { return min_weight_; }
 
-const std::vector<value> & Mixture::weights() const {
-    return weights_;
+std::vector<value> Mixture::weights() const {
+    
+    std::vector<value> w( weights_.size() );
+    
+    for (unsigned int c=0; c<weights_.size(); ++c) {
+        w[c] = weight(c);
+    }
+    
+    return w;
 }
 
-const std::vector<std::unique_ptr<Component>> & Mixture::components() const {
+const ComponentStore & Mixture::components() const {
     return kernels_;
 }
 
@@ -66,25 +111,83 @@ void Mixture::set_threshold( value v )  {
     
     threshold_ = v;
     threshold_squared_=threshold_*threshold_;
+    
+    // spatial index depends on threshold
+    index_.reset( new SpatialIndex( *space_, threshold_ ) );
+}
+
+void Mixture::set_max_components( unsigned int n ) {
+    max_components_ = n;
+    prune_();
+}
+
+void Mixture::set_min_weight( value v ) {
+    if (v<0. || v>=1.) {
+        throw std::runtime_error("Minimum weight should be in the range [0, 1).");
+    }
+    
+    min_weight_ = v;
+    prune_();
+}
+
+MixtureChanges Mixture::changes() const {
+    
+    MixtureChanges changes = changes_;
+    
+    std::sort( changes.modified.begin(), changes.modified.end() );
+    changes.modified.erase( std::unique( changes.modified.begin(), 
+        changes.modified.end() ), changes.modified.end() );
+    
+    return changes;
+}
+
+void Mixture::clear_changes() {
+    
+    changes_ = MixtureChanges();
+    changes_.ncomponents = kernels_.size();
+}
+
+uint64_t Mixture::fingerprint() const {
+    
+    uint64_t sizes[3] = { space_->ndim(), space_->nbw(), kernels_.size() };
+    
+    uint64_t h = hash_bytes( sizes, sizeof(sizes) );
+    h = hash_bytes( &sum_of_weights_, sizeof(value), h );
+    
+    auto w = weights();
+    h = hash_bytes( w.data(), w.size()*sizeof(value), h );
+    
+    for (unsigned int b=0; b<kernels_.nblocks(); ++b) {
+        h = hash_bytes( kernels_.block_locations(b), 
+            kernels_.block_size(b)*space_->ndim()*sizeof(value), h );
+        h = hash_bytes( kernels_.block_bandwidths(b), 
+            kernels_.block_size(b)*space_->nbw()*sizeof(value), h );
+    }
+    
+    return h;
 }
 
 // methods
 void Mixture::add_samples( const value * samples, unsigned int n, value w, value attenuation ) {
     
+    auto & kernel = space_->default_kernel();
+    
+    kernels_.reserve( kernels_.size() + n );
+    
     for (unsigned int k=0; k<n; ++k) {
-        try {
-            kernels_.emplace_back( space_->kernel( samples ) ); // note that sample are not checked and could contain invalid values!
-        } catch (std::exception & me) { // ToDo: catch proper exception
-            // remove all new components_
-            kernels_.resize( kernels_.size() - k );
-            throw;
-        }
+        // note that sample are not checked and could contain invalid values!
+        kernels_.append( samples, kernel.bandwidth.data(), kernel.scale_factor );
         samples += space_->ndim();
     }
     
     value weight = update_weights_( n, w, attenuation );
-    weights_.insert( weights_.end(), n, weight );
+    weights_.insert( weights_.end(), n, weight / weight_scale_ );
+    
+    if (n>0) {
+        min_relative_weight_ = std::min( min_relative_weight_, weight / weight_scale_ );
+    }
     
+    prune_();
 }
 
 void Mixture::merge_samples( const value * samples, unsigned int n, bool random, value w, value attenuation ) {
@@ -94,34 +197,128 @@ void Mixture::merge_samples( const value * samples, unsigned int n, bool random,
         return;
     }
     
-    unsigned int index=0;
-
-    //// create vector of new components
-    std::vector<std::unique_ptr<Component>> new_kernels;
+    auto & kernel = space_->default_kernel();
+    const value * bw = kernel.bandwidth.data();
     
-    for (unsigned int k=0; k<n; ++k) {
-        new_kernels.emplace_back( space_->kernel( samples ) );
-        samples += space_->ndim();
-    }
+    // order in which samples are merged
+    std::vector<unsigned int> order(n);
+    std::iota( order.begin(), order.end(), 0 );
     
     if (random) {
         std::random_device rd;
         std::mt19937 g(rd());
-        std::shuffle( new_kernels.begin(), new_kernels.end(), g );
+        std::shuffle( order.begin(), order.end(), g );
     }
     
     value weight = update_weights_( n, w, attenuation );
     
-    for (auto & c : new_kernels) {
-        if (closest( *c, index )) {
-            space_->merge( weights_[index], *kernels_[index], weight, *c );
-            weights_[index]+=weight;
-        } else { // add
-            kernels_.push_back( std::move( c ) );
-            weights_.push_back(weight);
+    sync_index_();
+    
+    for (auto & k : order) {
+        merge_component_( samples + k*space_->ndim(), bw, kernel.scale_factor, weight );
+    }
+    
+    // keep list of modified components compact
+    if (changes_.modified.size() > changes_.ncomponents) {
+        changes_ = changes();
+    }
+    
+    prune_();
+}
+
+void Mixture::merge_mixture( const Mixture & other ) {
+    
+    if (&other==this) {
+        Mixture copy( other );
+        merge_mixture( copy );
+        return;
+    }
+    
+    if (!(*other.space_==*space_)) {
+        throw std::runtime_error("Mixtures do not have the same space.");
+    }
+    
+    value total = sum_of_weights_ + other.sum_of_weights_;
+    
+    // samples seen by the other mixture are counted, even if none of its
+    // components remain
+    sum_of_nsamples_ += other.sum_of_nsamples_;
+    
+    if (other.kernels_.empty() || total<=0.) {
+        return;
+    }
+    
+    // weights of both mixtures are scaled by their share in the 
+    // combined sum of weights
+    value other_scale = other.sum_of_weights_ / total;
+    scale_weights_( sum_of_weights_ / total );
+    
+    sum_of_weights_ = total;
+    
+    sync_index_();
+    
+    kernels_.reserve( kernels_.size() + other.kernels_.size() );
+    
+    for (unsigned int c=0; c<other.kernels_.size(); ++c) {
+        if (threshold_==0.) {
+            append_component_( other.kernels_.location(c), other.kernels_.bandwidth(c),
+                other.kernels_.scale_factor(c), other.weight(c) * other_scale );
+        } else {
+            merge_component_( other.kernels_.location(c), other.kernels_.bandwidth(c),
+                other.kernels_.scale_factor(c), other.weight(c) * other_scale );
         }
     }
     
+    // keep list of modified components compact
+    if (changes_.modified.size() > changes_.ncomponents) {
+        changes_ = changes();
+    }
+    
+    prune_();
+}
+
+void Mixture::merge_component_( const value * loc, const value * bw, 
+    value scale_factor, value weight ) {
+    
+    unsigned int index=0;
+    
+    if (!closest( loc, index )) {
+        append_component_( loc, bw, scale_factor, weight );
+        return;
+    }
+    
+    space_->merge( this->weight(index), kernels_.mutable_location(index), 
+        kernels_.mutable_bandwidth(index), weight, loc, bw );
+    kernels_.update( index, 
+        space_->compute_scale_factor( kernels_.bandwidth(index) ) );
+    weights_[index]+=weight / weight_scale_;
+    if (index_->enabled()) {
+        index_->update( index, kernels_.location(index), 
+            kernels_.bandwidth(index) );
+    }
+    if (index<changes_.ncomponents) {
+        changes_.modified.push_back( index );
+    }
+}
+
+void Mixture::append_component_( const value * loc, const value * bw, 
+    value scale_factor, value weight ) {
+    
+    kernels_.append( loc, bw, scale_factor );
+    weights_.push_back(weight / weight_scale_);
+    min_relative_weight_ = std::min( min_relative_weight_, weights_.back() );
+    if (index_->enabled() && index_->size()+1==kernels_.size()) {
+        index_->insert( loc, bw );
+    }
+}
+
+void Mixture::reduce( unsigned int ncomponents ) {
+    reduce_( ncomponents, 0. );
+}
+
+void Mixture::reduce_threshold( value threshold ) {
+    set_threshold( threshold );
+    reduce_( kernels_.size(), threshold_squared_ );
 }
 
 void Mixture::evaluate( const value * points, unsigned int n, value * result ) {
@@ -140,27 +337,37 @@ void Mixture::evaluate( const value * points, unsigned int n, value * result ) {
     
     const value * ptr;
     value * res;
+    value scale;
     
     std::fill( result, result+n, 0. );
     
-    for (auto & c : kernels_) {
+    for (unsigned int c=0; c<kernels_.size(); ++c) {
         
         ptr = points;
         res = result;
+        scale = *weight * weight_scale_ * kernels_.scale_factor(c);
+        
+        ++weight;
+        
+        if (evaluator_) {
+            evaluator_->probability( kernels_.location(c), 
+                kernels_.inverse_bandwidth(c), points, n, space_->ndim(), 
+                scale, result );
+            continue;
+        }
         
         for (unsigned int k=0; k<n; ++k) {
-            *res += *weight * space_->probability( *c, ptr );
+            *res += scale * space_->probability( kernels_.location(c), 
+                kernels_.bandwidth(c), ptr );
             ++res;
             ptr += space_->ndim();
         }
         
-        ++weight;
-        
     }
     
 }
 
-void Mixture::evaluate( Grid & grid, value * result ) const {
+void Mixture::evaluate( const Grid & grid, value * result ) const {
     
     if (!(grid.specification()==space_->specification())) {
         throw std::runtime_error("Grid does not have the required space specification.");
@@ -171,15 +378,10 @@ void Mixture::evaluate( Grid & grid, value * result ) const {
     
     std::fill( result, result+grid.size(), 0. );
     
-    auto weight = weights_.cbegin();
-    
-    for (auto & c : kernels_) {
-        
-        space_->probability( grid, *weight * c->scale_factor, *c, result );
-        
-        ++weight;
-        
-    }
+    accumulate_( grid.size(), result, [&]( unsigned int c, value * out, unsigned int ) {
+        space_->probability( grid, weights_[c] * weight_scale_ * kernels_.scale_factor(c), 
+            kernels_.location(c), kernels_.bandwidth(c), out );
+    });
     
 }
 
@@ -191,16 +393,29 @@ void Mixture::partial( const value * points, unsigned int n, const std::vector<b
     
     unsigned int ndim = std::count( selection.begin(), selection.end(), true );
     
+    auto evaluator = make_evaluator( *space_, selection );
+    
     value log_scale;
     const value * ptr = points;
     
-    for (auto & c : kernels_) {
+    for (unsigned int c=0; c<kernels_.size(); ++c) {
+        
+        log_scale = space_->compute_scale_factor( selection.cbegin(), 
+            kernels_.bandwidth(c), true );
+        
+        if (evaluator) {
+            evaluator->partial_logp( kernels_.location(c), 
+                kernels_.inverse_bandwidth(c), points, n, ndim, result );
+            std::transform( result, result + n, result, 
+                [log_scale](const value & a) { return a + log_scale; } );
+            result += n;
+            continue;
+        }
         
-        log_scale = space_->compute_scale_factor( *c, selection, true );
-                
         for (unsigned int s=0; s<n; ++s) {
             
-            *result = space_->partial_logp( *c, ptr, selection ) + log_scale;
+            *result = space_->partial_logp( kernels_.location(c), 
+                kernels_.bandwidth(c), ptr, selection.cbegin() ) + log_scale;
             
             ++result;
             ptr += ndim;
@@ -216,26 +431,65 @@ PartialMixture* Mixture::partial( const value * points, unsigned int n, const st
     return new PartialMixture(this, selection, points, n);
 }
 
-void Mixture::partial( Grid & grid, value * result ) const {
+void Mixture::partial( const Grid & grid, value * result ) const {
+    
+    // rows of blocks of components are evaluated in parallel
+    unsigned int K = kernels_.size();
+    unsigned int nblocks = (K + PARALLEL_COMPONENT_BLOCK - 1) / PARALLEL_COMPONENT_BLOCK;
+    
+    parallel_for( pool_.get(), nblocks, [&]( unsigned int b, unsigned int ) {
+        
+        std::vector<unsigned int> components( std::min( PARALLEL_COMPONENT_BLOCK, 
+            K - b*PARALLEL_COMPONENT_BLOCK ) );
+        std::iota( components.begin(), components.end(), b*PARALLEL_COMPONENT_BLOCK );
+        
+        partial( grid, components, 
+            result + (size_t) b * PARALLEL_COMPONENT_BLOCK * grid.size() );
+    });
+}
+
+PartialMixture* Mixture::partial( const Grid & grid ) const {
+    return new PartialMixture(this, grid);
+}
+
+void Mixture::partial( const Grid & grid, 
+    const std::vector<unsigned int> & components, value * result ) const {
     
     value log_scale;
     
     auto selection = space().specification().selection( grid.specification() );
     
-    for (auto & c : kernels_) {
+    for (auto & c : components) {
         
-        log_scale = space_->compute_scale_factor( *c, selection, true );
+        log_scale = space_->compute_scale_factor( selection.cbegin(), 
+            kernels_.bandwidth(c), true );
         
-        space_->partial_logp( grid, selection, log_scale, *c, result );
+        space_->partial_logp( grid, selection.cbegin(), log_scale, 
+            kernels_.location(c), kernels_.bandwidth(c), result );
         
         result += grid.size();
-        
     }
-    
 }
 
-PartialMixture* Mixture::partial( Grid & grid ) const {
-    return new PartialMixture(this, grid);
+void Mixture::partial_factors( const Grid & grid, 
+    const std::vector<unsigned int> & components, value * result ) const {
+    
+    value log_scale;
+    
+    auto selection = space().specification().selection( grid.specification() );
+    auto sizes = grid.factor_sizes( *space_ );
+    unsigned int n = std::accumulate( sizes.begin(), sizes.end(), 0u );
+    
+    for (auto & c : components) {
+        
+        log_scale = space_->compute_scale_factor( selection.cbegin(), 
+            kernels_.bandwidth(c), true );
+        
+        grid.partial_logp_factors( *space_, selection.cbegin(), log_scale, 
+            kernels_.location(c), kernels_.bandwidth(c), result );
+        
+        result += n;
+    }
 }
 
 void Mixture::marginal( const value * points, unsigned int n, const std::vector<bool> & selection, value * result ) const {
@@ -246,29 +500,40 @@ void Mixture::marginal( const value * points, unsigned int n, const std::vector<
     
     unsigned int ndim = std::count( selection.begin(), selection.end(), true );
     
-    value * out;
-    value tmp;
+    std::vector<value> tmp(n);
+    std::vector<value> p(n);
     
     std::vector<value>::const_iterator weight = weights_.cbegin();
     
+    auto evaluator = make_evaluator( *space_, selection );
+    
     value log_scale;
     const value * ptr = points;
     
-    for (auto & c : kernels_) {
+    for (unsigned int c=0; c<kernels_.size(); ++c) {
+        
+        log_scale = space_->compute_scale_factor( selection.cbegin(), 
+            kernels_.bandwidth(c), true );
         
-        out = result;
+        if (evaluator) {
+            evaluator->partial_logp( kernels_.location(c), 
+                kernels_.inverse_bandwidth(c), points, n, ndim, tmp.data() );
+            std::transform( tmp.begin(), tmp.end(), tmp.begin(), 
+                [log_scale](const value & a) { return a + log_scale; } );
+        } else {
+            for (unsigned int s=0; s<n; ++s) {
+                tmp[s] = space_->partial_logp( kernels_.location(c), 
+                    kernels_.bandwidth(c), ptr, selection.cbegin() ) + log_scale;
+                ptr += ndim;
+            }
+        }
         
-        log_scale = space_->compute_scale_factor( *c, selection, true );
+        fastexp_n( tmp.data(), p.data(), n );
         
         for (unsigned int s=0; s<n; ++s) {
-            tmp = space_->partial_logp( *c, ptr, selection ) + log_scale;
-            
-            if (!std::isinf(tmp)) {
-                *out += *weight * fastexp( tmp );
+            if (!std::isinf(tmp[s])) {
+                result[s] += *weight * weight_scale_ * p[s];
             }
-            
-            ++out;
-            ptr += ndim;
         }
         
         ++weight;
@@ -276,26 +541,31 @@ void Mixture::marginal( const value * points, unsigned int n, const std::vector<
     }
 }
 
-void Mixture::marginal( Grid & grid, value * result ) const {
+void Mixture::marginal( const Grid & grid, value * result ) const {
     
-    value log_scale;
     auto selection = space().specification().selection( grid.specification() );
-    std::vector<value>::const_iterator weight = weights_.cbegin();
-    std::vector<value> tmp(grid.size());
     
-    for (auto & c : kernels_) {
-        log_scale = space_->compute_scale_factor( *c, selection, true );
-        log_scale += fastlog( *weight );
+    // scratch space per worker
+    std::vector<std::vector<value>> tmp( nthreads(), std::vector<value>(grid.size()) );
+    std::vector<std::vector<value>> p( nthreads(), std::vector<value>(grid.size()) );
+    
+    accumulate_( grid.size(), result, [&]( unsigned int c, value * out, unsigned int worker ) {
         
-        space_->partial_logp( grid, selection, log_scale, *c, tmp.data() );
+        value log_scale = space_->compute_scale_factor( selection.cbegin(), 
+            kernels_.bandwidth(c), true );
+        log_scale += fastlog( weights_[c] * weight_scale_ );
+        
+        space_->partial_logp( grid, selection.cbegin(), log_scale, 
+            kernels_.location(c), kernels_.bandwidth(c), tmp[worker].data() );
+        
+        fastexp_n( tmp[worker].data(), p[worker].data(), grid.size() );
         
         for (unsigned int k=0; k<grid.size(); ++k) {
-            if (!std::isinf(tmp[k])) {
-                result[k] += fastexp( tmp[k] );
+            if (!std::isinf(tmp[worker][k])) {
+                out[k] += p[worker][k];
             }
         }
-        ++weight;
-    }
+    });
 }
 
 // protected methods
@@ -310,9 +580,7 @@ value Mixture::update_weights_( unsigned int nsamples ) {
     value weight = mixing_factor_new / nsamples;
     
     //adjust weights of existing components
-    for (auto & w : weights_) {
-        w *= mixing_factor_old;
-    }
+    scale_weights_( mixing_factor_old );
     
     return weight;
     
@@ -333,150 +601,478 @@ value Mixture::update_weights_( unsigned int nsamples, value weight, value atten
     value w = mixing_factor_new / sum_sample_weights;
     
     //adjust weights of existing components
-    for (auto & k : weights_) {
-        k *= mixing_factor_old;
-    }
+    scale_weights_( mixing_factor_old );
     
     return w;
     
 }
 
-bool Mixture::closest( const Component & target, unsigned int & index, value threshold_squared) const {
+void Mixture::scale_weights_( value factor ) {
     
-    value min_distance = threshold_squared;
-    value distance;
+    changes_.weight_scale *= factor;
     
-    for (unsigned int k=0; k<kernels_.size(); ++k) {
-        //distance = kernels_[k]->mahalanobis_distance_squared( target, threshold_squared );
-        distance = space_->mahalanobis_distance_squared( *kernels_[k], target, threshold_squared );
-        if (distance<min_distance) {
-            min_distance=distance;
-            index = k;
-        }
+    if (factor==0.) {
+        std::fill( weights_.begin(), weights_.end(), 0. );
+        weight_scale_ = 1.;
+        min_relative_weight_ = weights_.empty() ? 
+            std::numeric_limits<value>::infinity() : 0.;
+        return;
     }
     
-    return (min_distance<threshold_squared);
-}
-
-bool Mixture::closest( const Component & k, unsigned int & index ) const {
-    return closest( k, index, threshold_squared_ );
+    weight_scale_ *= factor;
+    
+    // fold scale factor into weights before it under- or overflows
+    if (weight_scale_<MIN_WEIGHT_SCALE || weight_scale_>MAX_WEIGHT_SCALE) {
+        for (auto & w : weights_) {
+            w *= weight_scale_;
+        }
+        min_relative_weight_ *= weight_scale_;
+        weight_scale_ = 1.;
+    }
 }
 
-
-// yaml
-YAML::Node Mixture::to_yaml() const {
-    YAML::Node node;
+void Mixture::prune_() {
     
-    node["sum_of_weights"] = sum_of_weights_;
-    node["sum_of_nsamples"] = sum_of_nsamples_;
-    node["threshold"] = threshold_;
-    node["nkernels"] = kernels_.size();
-    node["space"] = space_->to_yaml();
+    unsigned int n = kernels_.size();
     
-    node["kernels"] = YAML::Load("[]");
+    bool below_min = min_weight_>0. && min_relative_weight_*weight_scale_<min_weight_;
+    bool above_max = max_components_>0 && n>max_components_;
+    
+    if (!below_min && !above_max) { return; }
+    
+    // components below the minimum weight are also the lowest weight 
+    // components, so in both cases the nremove lowest weight components
+    // are removed. A margin is removed as well, such that the next updates
+    // do not immediately trigger pruning again.
+    unsigned int nremove = 0;
     
-    for (auto & k : kernels_) {
-        node["kernels"].push_back( k->to_yaml() );
+    if (above_max) {
+        unsigned int target = std::max( 1u, static_cast<unsigned int>( 
+            PRUNE_HYSTERESIS * max_components_ ) );
+        nremove = n - std::min( n, target );
     }
-    node["weights"] = weights_;
     
-    return node;
+    if (below_min) {
+        value threshold = min_weight_ / ( PRUNE_HYSTERESIS * weight_scale_ );
+        nremove = std::max( nremove, static_cast<unsigned int>( 
+            std::count_if( weights_.begin(), weights_.end(), 
+            [threshold](const value & w) { return w<threshold; } ) ) );
+    }
     
+    // always keep at least one component
+    nremove = std::min( nremove, n>0 ? n-1 : 0 );
+    
+    if (nremove==0) {
+        min_relative_weight_ = weights_.empty() ? std::numeric_limits<value>::infinity() :
+            *std::min_element( weights_.begin(), weights_.end() );
+        return;
+    }
+    
+    std::vector<unsigned int> order(n);
+    std::iota( order.begin(), order.end(), 0 );
+    
+    std::nth_element( order.begin(), order.begin() + nremove, order.end(), 
+        [this](const unsigned int & a, const unsigned int & b) {
+            return weights_[a]<weights_[b]; } );
+    
+    order.resize( nremove );
+    std::sort( order.begin(), order.end() );
+    
+    value total = std::accumulate( weights_.begin(), weights_.end(), 0. );
+    value removed = remove_components_( order );
+    
+    // redistribute weight of removed components, such that the weights
+    // remain normalized and consistent with sum_of_weights
+    if (removed>0. && total>removed) {
+        scale_weights_( total / (total - removed) );
+    }
 }
 
-void Mixture::save_to_yaml( std::ostream & stream ) const {
-    auto node = to_yaml(); 
-    YAML::Emitter out; 
-    out << YAML::Flow; 
-    out << node; 
-    stream << out.c_str();
-}
-void Mixture::save_to_yaml( std::string path ) const {
-    std::ofstream fout(path);
-    save_to_yaml(fout);
-}
-
-std::unique_ptr<Mixture> Mixture::from_yaml( const YAML::Node & node ) {
+value Mixture::remove_components_( const std::vector<unsigned int> & indices ) {
     
-    if (!node["space"] || !node["weights"].IsSequence() || 
-        !node["kernels"].IsSequence() || 
-         node["weights"].size()!=node["kernels"].size()) {
-        throw std::runtime_error( "Cannot retrieve weights or kernels.");
+    value removed = 0.;
+    
+    // compact weights
+    unsigned int dst = 0;
+    auto next = indices.cbegin();
+    
+    min_relative_weight_ = std::numeric_limits<value>::infinity();
+    
+    for (unsigned int c=0; c<weights_.size(); ++c) {
+        if (next!=indices.cend() && *next==c) {
+            removed += weights_[c];
+            ++next;
+            continue;
+        }
+        weights_[dst++] = weights_[c];
+        min_relative_weight_ = std::min( min_relative_weight_, weights_[c] );
     }
     
-    auto space = space_from_yaml( node["space"] );
-    value threshold = node["threshold"].as<value>( THRESHOLD );
+    weights_.resize( dst );
+    kernels_.remove( indices );
     
-    auto m = std::make_unique<Mixture>(*space, threshold);
+    // component indices have changed
+    index_->clear();
+    changes_.modified.clear();
+    changes_.reset = true;
     
-    unsigned int nkernels = node["kernels"].size();
+    return removed;
+}
+
+void Mixture::reduce_( unsigned int ncomponents, value threshold_squared ) {
+    
+    unsigned int n = kernels_.size();
+    
+    if (n<2 || (n<=ncomponents && threshold_squared<=0.)) { return; }
+    
+    const value inf = std::numeric_limits<value>::infinity();
+    
+    // merge cost is the smallest mahalanobis distance of either location 
+    // relative to the other component, as in merge_samples
+    auto distance = [this]( unsigned int a, unsigned int b, value max ) {
+        value d = space_->mahalanobis_distance_squared( 
+            kernels_.location(a), kernels_.bandwidth(a), kernels_.location(b), max );
+        return std::min( d, space_->mahalanobis_distance_squared( 
+            kernels_.location(b), kernels_.bandwidth(b), kernels_.location(a), std::min(d, max) ) );
+    };
+    
+    // closest component of each component and the merge cost
+    std::vector<unsigned int> nearest(n, 0);
+    std::vector<value> cost(n, inf);
+    std::vector<bool> removed(n, false);
+    
+    // version of each component, which changes when it absorbs another 
+    // component, and the version of the closest component at the time of 
+    // the search
+    std::vector<unsigned int> version(n, 0);
+    std::vector<unsigned int> nearest_version(n, 0);
+    
+    // queue entries (cost, component, stamp) are outdated if the stamp 
+    // of the component has changed
+    std::vector<unsigned int> stamp(n, 0);
+    typedef std::tuple<value, unsigned int, unsigned int> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+    
+    // the search for the closest component visits rings of cells around the 
+    // component in a spatial index, until no closer component can be found.
+    // The index only holds remaining components and it is rebuilt with 
+    // larger cells whenever the number of components has halved.
+    SpatialIndex index( *space_, std::max<value>( 1., std::sqrt(threshold_squared) ) );
+    std::vector<unsigned int> members;
+    std::vector<unsigned int> slot(n, 0);
+    
+    auto build_index = [&]() {
+        index.clear();
+        members.clear();
+        for (unsigned int c=0; c<n; ++c) {
+            if (removed[c]) { continue; }
+            slot[c] = members.size();
+            members.push_back( c );
+            index.insert( kernels_.location(c), kernels_.bandwidth(c) );
+        }
+        index.coarsen( REDUCE_CELL_OCCUPANCY );
+    };
     
-    m->sum_of_weights_ = node["sum_of_weights"].as<value>( nkernels );
-    m->sum_of_nsamples_ = node["sum_of_nsamples"].as<value>( nkernels );
+    build_index();
     
-    m->weights_ = node["weights"].as<std::vector<value>>();
+    std::vector<unsigned int> candidates;
     
-    for (unsigned int k=0; k<nkernels; ++k){
-        try {
-            m->kernels_.push_back(std::move(Component::from_yaml( node["kernels"][k])));
-            
-            if (m->kernels_.back()->location.size()!=space->ndim() || 
-                m->kernels_.back()->bandwidth.size()!=space->nbw()) {
-                throw std::runtime_error("Component vector sizes do not match space.");
+    auto update_nearest = [&]( unsigned int c ) {
+        
+        cost[c] = inf;
+        
+        // ties are resolved in favor of the lowest index, as in a full search
+        auto test = [&]( unsigned int k ) {
+            if (k==c || removed[k]) { return; }
+            value d = distance( c, k, cost[c] );
+            if (d<cost[c] || (d==cost[c] && k<nearest[c])) {
+                cost[c] = d;
+                nearest[c] = k;
             }
-            
-            space->update_scale_factor( *m->kernels_.back() );
-            
-        } catch (std::exception & me) { // ToDo: catch proper exception
-            throw std::runtime_error("Cannot load kernel data.");
+        };
+        
+        if (index.enabled()) {
+            for (unsigned int r=0; cost[c]>=index.ring_distance_squared( kernels_.bandwidth(c), r ); ++r) {
+                bool more = index.ring( kernels_.location(c), r, candidates );
+                for (auto & k : candidates) { test( members[k] ); }
+                if (!more) { break; }
+            }
+        } else {
+            for (unsigned int k=0; k<n; ++k) { test( k ); }
+        }
+        
+        ++stamp[c];
+        if (cost[c]<inf) {
+            nearest_version[c] = version[nearest[c]];
+            queue.emplace( cost[c], c, stamp[c] );
         }
+    };
+    
+    for (unsigned int c=0; c<n; ++c) {
+        update_nearest( c );
     }
     
-    return m;
-}
-std::unique_ptr<Mixture> Mixture::load_from_yaml( std::string path ) {
-    std::ifstream ifs(path, std::ifstream::in);
+    unsigned int remaining = n;
     
-    auto node = YAML::Load( ifs );
+    while (!queue.empty()) {
+        
+        value d;
+        unsigned int a, s;
+        std::tie( d, a, s ) = queue.top();
+        
+        if (remaining<=ncomponents && d>=threshold_squared) { break; }
+        
+        queue.pop();
+        
+        if (removed[a] || s!=stamp[a]) { continue; }
+        
+        // if the closest component has changed, the cost is a lower bound 
+        // for all merges of this component that are not covered by the 
+        // search for the changed component (the merge cost is symmetric),
+        // so the search is only repeated when the entry reaches the top
+        if (removed[nearest[a]] || version[nearest[a]]!=nearest_version[a]) {
+            update_nearest( a );
+            continue;
+        }
+        
+        // merge into component with lowest index
+        unsigned int keep = std::min( a, nearest[a] );
+        unsigned int drop = std::max( a, nearest[a] );
+        
+        value * loc = kernels_.mutable_location(keep);
+        value * bw = kernels_.mutable_bandwidth(keep);
+        
+        space_->merge( weight(keep), loc, bw, weight(drop), 
+            kernels_.location(drop), kernels_.bandwidth(drop) );
+        kernels_.update( keep, 
+            space_->compute_scale_factor( kernels_.bandwidth(keep) ) );
+        weights_[keep] += weights_[drop];
+        weights_[drop] = 0.;
+        
+        removed[drop] = true;
+        ++stamp[drop];
+        ++version[keep];
+        --remaining;
+        
+        if (2*remaining<=members.size()) {
+            build_index();
+        } else {
+            index.update( slot[keep], kernels_.location(keep), kernels_.bandwidth(keep) );
+        }
+        
+        update_nearest( keep );
+    }
     
-    return Mixture::from_yaml( node );
+    if (remaining==n) { return; }
+    
+    std::vector<unsigned int> indices;
+    for (unsigned int c=0; c<n; ++c) {
+        if (removed[c]) { indices.push_back( c ); }
+    }
+    
+    remove_components_( indices );
 }
 
-// flatbuffers
-flatbuffers::Offset<fb_serialize::Mixture> Mixture::to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const {
+bool Mixture::closest( const value * target, unsigned int & index, value threshold_squared) const {
+    
+    // distances divide by the bandwidth rather than multiply by its stored
+    // inverse, so that near-ties and merge decisions do not change
+    value min_distance = threshold_squared;
+    value distance;
+    
+    // only consider components close to target if spatial index is valid
+    if (index_->enabled() && index_->size()==kernels_.size() && 
+        threshold_squared<=threshold_squared_) {
+        
+        index_->candidates( target, candidates_ );
+        
+        // candidates are sorted, so that ties are resolved as in full search
+        for (auto & k : candidates_) {
+            distance = space_->mahalanobis_distance_squared( 
+                kernels_.location(k), kernels_.bandwidth(k), target, threshold_squared );
+            if (distance<min_distance) {
+                min_distance=distance;
+                index = k;
+            }
+        }
+        
+        return (min_distance<threshold_squared);
+    }
+    
+    for (unsigned int k=0; k<kernels_.size(); ++k) {
+        distance = space_->mahalanobis_distance_squared( 
+            kernels_.location(k), kernels_.bandwidth(k), target, threshold_squared );
+        if (distance<min_distance) {
+            min_distance=distance;
+            index = k;
+        }
+    }
+    
+    return (min_distance<threshold_squared);
+}
 
-    auto space = space_->to_flatbuffers(builder);
+bool Mixture::closest( const value * loc, unsigned int & index ) const {
+    return closest( loc, index, threshold_squared_ );
+}
 
-    // kernels is Kernels table with locations and bandwidths fields
-    // it doesn't look like we can build vectors incrementally
-    // so we collect kernel locations/bandwidths in a single vector
-    std::vector<value> locations;
-    locations.reserve(space_->ndim() * kernels_.size());
+void Mixture::accumulate_( unsigned int n, value * result, 
+    const std::function<void(unsigned int, value *, unsigned int)> & fcn ) const {
+    
+    unsigned int K = kernels_.size();
+    
+    if (nthreads()<2 || K<=PARALLEL_COMPONENT_BLOCK) {
+        for (unsigned int c=0; c<K; ++c) { fcn( c, result, 0 ); }
+        return;
+    }
+    
+    // per worker sums
+    std::vector<std::vector<value>> sums( nthreads() );
+    unsigned int nblocks = (K + PARALLEL_COMPONENT_BLOCK - 1) / PARALLEL_COMPONENT_BLOCK;
+    
+    parallel_for( pool_.get(), nblocks, [&]( unsigned int b, unsigned int worker ) {
+        
+        sums[worker].resize( n, 0. );
+        
+        unsigned int end = std::min( K, (b+1)*PARALLEL_COMPONENT_BLOCK );
+        for (unsigned int c=b*PARALLEL_COMPONENT_BLOCK; c<end; ++c) {
+            fcn( c, sums[worker].data(), worker );
+        }
+    });
+    
+    // reduction in fixed order
+    for (auto & sum : sums) {
+        if (sum.empty()) { continue; }
+        std::transform( result, result + n, sum.begin(), result, std::plus<value>() );
+    }
+}
+
+void Mixture::sync_index_() {
+    
+    if (!index_->enabled() || index_->size()==kernels_.size()) {
+        return;
+    }
+    
+    index_->clear();
+    
+    for (unsigned int k=0; k<kernels_.size(); ++k) {
+        index_->insert( kernels_.location(k), kernels_.bandwidth(k) );
+    }
+}
+
+
+// yaml
+YAML::Node Mixture::to_yaml() const {
+    YAML::Node node;
+    
+    node["sum_of_weights"] = sum_of_weights_;
+    node["sum_of_nsamples"] = sum_of_nsamples_;
+    node["threshold"] = threshold_;
+    node["max_components"] = max_components_;
+    node["min_weight"] = min_weight_;
+    node["nkernels"] = kernels_.size();
+    node["space"] = space_->to_yaml();
+    
+    node["kernels"] = YAML::Load("[]");
+    
+    for (unsigned int k=0; k<kernels_.size(); ++k) {
+        node["kernels"].push_back( kernels_.component(k).to_yaml() );
+    }
+    node["weights"] = weights();
+    
+    return node;
+    
+}
 
-    std::vector<value> bandwidths;
-    bandwidths.reserve(space_->nbw() * kernels_.size());
+void Mixture::save_to_yaml( std::ostream & stream ) const {
+    auto node = to_yaml(); 
+    YAML::Emitter out; 
+    out << YAML::Flow; 
+    out << node; 
+    stream << out.c_str();
+}
+void Mixture::save_to_yaml( std::string path ) const {
+    std::ofstream fout(path);
+    save_to_yaml(fout);
+}
 
-    for (auto & k : kernels_) {
-        locations.insert(locations.end(), k->location.begin(), k->location.end());
-        bandwidths.insert(bandwidths.end(), k->bandwidth.begin(), k->bandwidth.end());
+std::unique_ptr<Mixture> Mixture::from_yaml( const YAML::Node & node ) {
+    
+    if (!node["space"] || !node["weights"].IsSequence() || 
+        !node["kernels"].IsSequence() || 
+         node["weights"].size()!=node["kernels"].size()) {
+        throw std::runtime_error( "Cannot retrieve weights or kernels.");
     }
+    
+    auto space = space_from_yaml( node["space"] );
+    value threshold = node["threshold"].as<value>( THRESHOLD );
+    
+    auto m = std::make_unique<Mixture>(*space, threshold);
+    
+    unsigned int nkernels = node["kernels"].size();
+    
+    m->sum_of_weights_ = node["sum_of_weights"].as<value>( nkernels );
+    m->sum_of_nsamples_ = node["sum_of_nsamples"].as<value>( nkernels );
+    
+    m->weights_ = node["weights"].as<std::vector<value>>();
+    m->min_relative_weight_ = 0.;
+    
+    m->max_components_ = node["max_components"].as<unsigned int>( 0 );
+    m->min_weight_ = node["min_weight"].as<value>( 0. );
+    
+    m->kernels_.reserve( nkernels );
+    
+    for (unsigned int k=0; k<nkernels; ++k){
+        try {
+            auto c = Component::from_yaml( node["kernels"][k] );
+            
+            if (c->location.size()!=space->ndim() || 
+                c->bandwidth.size()!=space->nbw()) {
+                throw std::runtime_error("Component vector sizes do not match space.");
+            }
+            
+            m->kernels_.append( c->location.data(), c->bandwidth.data(), 
+                space->compute_scale_factor( c->bandwidth.data() ) );
+            
+        } catch (std::exception & me) { // ToDo: catch proper exception
+            throw std::runtime_error("Cannot load kernel data.");
+        }
+    }
+    
+    return m;
+}
+std::unique_ptr<Mixture> Mixture::load_from_yaml( std::string path ) {
+    std::ifstream ifs(path, std::ifstream::in);
+    
+    auto node = YAML::Load( ifs );
+    
+    return Mixture::from_yaml( node );
+}
+
+// flatbuffers
+flatbuffers::Offset<fb_serialize::Mixture> Mixture::to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const {
 
+    auto space = space_->to_flatbuffers(builder);
+
+    // kernels is Kernels table with locations and bandwidths fields
+    // which have the same layout as the component store
     auto kernels = fb_serialize::CreateKernels(
         builder,
         space_->ndim(),
         space_->nbw(),
         kernels_.size(),
-        builder.CreateVector(locations),
-        builder.CreateVector(bandwidths)
+        builder.CreateVector(kernels_.locations()),
+        builder.CreateVector(kernels_.bandwidths())
     );
 
-    auto weights = builder.CreateVector(weights_);
+    auto weights = builder.CreateVector(this->weights());
 
     fb_serialize::MixtureBuilder mixture_builder(builder);
 
     mixture_builder.add_sum_of_weights(sum_of_weights_);
     mixture_builder.add_sum_of_nsamples(sum_of_nsamples_);
     mixture_builder.add_threshold(threshold_);
+    mixture_builder.add_max_components(max_components_);
+    mixture_builder.add_min_weight(min_weight_);
     mixture_builder.add_space(space);
     mixture_builder.add_kernels(kernels);
     mixture_builder.add_weights(weights);
@@ -486,7 +1082,8 @@ flatbuffers::Offset<fb_serialize::Mixture> Mixture::to_flatbuffers(flatbuffers::
     return fb_mix;
 }
 
-std::unique_ptr<Mixture> Mixture::from_flatbuffers(const fb_serialize::Mixture * mixture) {
+std::unique_ptr<Mixture> Mixture::from_flatbuffers(const fb_serialize::Mixture * mixture,
+    std::shared_ptr<const void> owner) {
 
     auto threshold = mixture->threshold();
     auto space = space_from_flatbuffers(mixture->space());
@@ -496,19 +1093,83 @@ std::unique_ptr<Mixture> Mixture::from_flatbuffers(const fb_serialize::Mixture *
     m->sum_of_weights_ = mixture->sum_of_weights();
     m->sum_of_nsamples_ = mixture->sum_of_nsamples();
 
+    m->max_components_ = mixture->max_components();
+    m->min_weight_ = mixture->min_weight();
+
+    // a file that passes the verifier may still lack fields or have
+    // inconsistent sizes
     auto weights = mixture->weights();
+    auto kernels = mixture->kernels();
+
+    if (!weights || !kernels || !kernels->locations() || !kernels->bandwidth()) {
+        throw std::runtime_error("Cannot load kernel data.");
+    }
+
+    auto ndim = kernels->ndim();
+    auto nbw = kernels->nbw();
+    auto nkernels = kernels->nkernels();
+
+    if (ndim!=space->ndim() || nbw!=space->nbw() || 
+        weights->size()!=nkernels ||
+        kernels->locations()->size()!=ndim*nkernels ||
+        kernels->bandwidth()->size()!=nbw*nkernels) {
+        throw std::runtime_error("Cannot load kernel data.");
+    }
+
     m->weights_.insert(m->weights_.begin(), weights->begin(), weights->end());
+    m->min_relative_weight_ = 0.;
+
+    if (owner) {
+        
+        // components refer to the buffer
+        const value * bandwidths = kernels->bandwidth()->data();
+        
+        std::vector<value> scale_factors(nkernels);
+        for (unsigned int k=0; k<nkernels; ++k) {
+            scale_factors[k] = space->compute_scale_factor(bandwidths + k*nbw);
+        }
+        
+        m->kernels_.assign_external(nkernels, kernels->locations()->data(), 
+            bandwidths, scale_factors, owner);
+        
+        return m;
+    }
 
-    m->kernels_ = components_from_flatbuffers(mixture->kernels());
+    std::vector<value> locations(kernels->locations()->cbegin(), kernels->locations()->cend());
+    std::vector<value> bandwidths(kernels->bandwidth()->cbegin(), kernels->bandwidth()->cend());
 
-    for (auto & k : m->kernels_) {
-        space->update_scale_factor(*k);
+    m->kernels_.reserve(nkernels);
+
+    for (unsigned int k=0; k<nkernels; ++k) {
+        m->kernels_.append(
+            locations.data() + k*ndim,
+            bandwidths.data() + k*nbw,
+            space->compute_scale_factor(bandwidths.data() + k*nbw)
+        );
     }
 
     return m;
 }
 
 
+void Mixture::save_to_flatbuffers_file( std::string filename ) const {
+    
+    flatbuffers::FlatBufferBuilder builder(1024);
+    builder.Finish( to_flatbuffers(builder) );
+    
+    save_flatbuffer( builder, filename );
+}
+
+std::unique_ptr<Mixture> Mixture::load_from_flatbuffers_file( std::string filename ) {
+    
+    auto file = std::make_shared<MappedFile>( filename );
+    
+    // the mapping stays alive as long as any component refers to it
+    return Mixture::from_flatbuffers( 
+        file->flatbuffer_root<fb_serialize::Mixture>(), file );
+}
+
+
 // hdf5
 void Mixture::to_hdf5(HighFive::Group & group) const {
     
@@ -521,33 +1182,72 @@ void Mixture::to_hdf5(HighFive::Group & group) const {
     HighFive::DataSet ds_th = group.createDataSet<value>("threshold", HighFive::DataSpace::From(threshold_));
     ds_th.write(threshold_);
     
+    HighFive::DataSet ds_maxc = group.createDataSet<unsigned int>("max_components", HighFive::DataSpace::From(max_components_));
+    ds_maxc.write(max_components_);
+    
+    HighFive::DataSet ds_minw = group.createDataSet<value>("min_weight", HighFive::DataSpace::From(min_weight_));
+    ds_minw.write(min_weight_);
+    
     HighFive::DataSet ds_nk = group.createDataSet<unsigned int>("nkernels", HighFive::DataSpace::From(kernels_.size()));
     ds_nk.write(kernels_.size());
     
     HighFive::Group space_group = group.createGroup("space");
     space_->to_hdf5(space_group);
     
-    HighFive::DataSet ds_w = group.createDataSet<value>("weights", HighFive::DataSpace::From(weights_));
-    ds_w.write(weights_);
+    auto weights = this->weights();
+    HighFive::DataSet ds_w = group.createDataSet<value>("weights", 
+        HighFive::DataSpace::From(weights), component_dataset_props_( {kernels_.size()} ));
+    ds_w.write(weights);
     
     HighFive::Group subgroup = group.createGroup("kernels");
     
+    // [ndim x K] location and [nbw x K] bandwidth matrices are written
+    // in a single call each
+    unsigned int K = kernels_.size();
+    unsigned int ndim = space_->ndim();
+    unsigned int nbw = space_->nbw();
+    
     HighFive::DataSet ds_loc = subgroup.createDataSet<value>("location",
-        HighFive::DataSpace({space_->ndim(),kernels_.size()}));
+        HighFive::DataSpace({ndim, K}), component_dataset_props_( {ndim, K} ));
     
     HighFive::DataSet ds_bw = subgroup.createDataSet<value>("bandwidth",
-        HighFive::DataSpace({space_->nbw(), kernels_.size()}));
+        HighFive::DataSpace({nbw, K}), component_dataset_props_( {nbw, K} ));
     
-    unsigned int n = 0;
+    std::vector<value> loc( ndim*K );
+    std::vector<value> bw( nbw*K );
     
-    for (auto & k : kernels_) {
-        
-        ds_loc.select({0,n},{space_->ndim(),1}).write(k->location);
-        ds_bw.select({0,n},{space_->nbw(),1}).write(k->bandwidth);
-        
-        ++n;
+    for (unsigned int k=0; k<K; ++k) {
+        for (unsigned int d=0; d<ndim; ++d) {
+            loc[d*K + k] = kernels_.location(k)[d];
+        }
+        for (unsigned int d=0; d<nbw; ++d) {
+            bw[d*K + k] = kernels_.bandwidth(k)[d];
+        }
     }
     
+    if (K>0) {
+        ds_loc.write_raw( loc.data() );
+        ds_bw.write_raw( bw.data() );
+    }
+}
+
+HighFive::DataSetCreateProps Mixture::component_dataset_props_( 
+    const std::vector<size_t> & dims ) {
+    
+    HighFive::DataSetCreateProps props;
+    
+    // chunks span all rows and HDF5_CHUNK_COMPONENTS components (columns),
+    // and cannot be empty
+    std::vector<hsize_t> chunk( dims.begin(), dims.end() );
+    chunk.back() = std::min<hsize_t>( chunk.back(), HDF5_CHUNK_COMPONENTS );
+    
+    if (std::find( chunk.begin(), chunk.end(), 0 )==chunk.end()) {
+        props.add( HighFive::Chunking( chunk ) );
+        props.add( HighFive::Shuffle() );
+        props.add( HighFive::Deflate( HDF5_DEFLATE_LEVEL ) );
+    }
+    
+    return props;
 }
 
 void Mixture::save_to_hdf5( std::string filename, int flags, std::string path) {
@@ -596,23 +1296,49 @@ std::unique_ptr<Mixture> Mixture::from_hdf5(const HighFive::Group & group) {
     group.getDataSet("sum_of_weights").read(m->sum_of_weights_);
     group.getDataSet("sum_of_nsamples").read(m->sum_of_nsamples_);
     group.getDataSet("weights").read(m->weights_);
+    m->min_relative_weight_ = 0.;
+    
+    // size bounds are optional
+    if (group.exist("max_components")) {
+        group.getDataSet("max_components").read(m->max_components_);
+    }
+    if (group.exist("min_weight")) {
+        group.getDataSet("min_weight").read(m->min_weight_);
+    }
     
     HighFive::DataSet loc = group.getGroup("kernels").getDataSet("location");
     HighFive::DataSet bw = group.getGroup("kernels").getDataSet("bandwidth");
     
-    for (unsigned int k=0; k<nkernels; ++k){
-        try {
-            auto comp = std::make_unique<Component>();
-            loc.select({0,k},{space->ndim(),1}).read(comp->location);
-            bw.select({0,k},{space->nbw(),1}).read(comp->bandwidth);
-            
-            m->kernels_.push_back(std::move(comp));
-            
-            space->update_scale_factor( *m->kernels_.back() );
-            
-        } catch (std::exception & me) { // ToDo: catch proper exception
-            throw std::runtime_error("Cannot load kernel data.");
-        }
+    unsigned int ndim = space->ndim();
+    unsigned int nbw = space->nbw();
+    
+    if (loc.getSpace().getDimensions()!=std::vector<size_t>{ndim, nkernels} ||
+        bw.getSpace().getDimensions()!=std::vector<size_t>{nbw, nkernels} ||
+        m->weights_.size()!=nkernels) {
+        throw std::runtime_error("Cannot load kernel data.");
+    }
+    
+    // [ndim x K] location and [nbw x K] bandwidth matrices are read
+    // in a single call each
+    std::vector<value> kloc( ndim*nkernels );
+    std::vector<value> kbw( nbw*nkernels );
+    
+    if (nkernels>0) {
+        loc.read( kloc.data() );
+        bw.read( kbw.data() );
+    }
+    
+    std::vector<value> l( ndim );
+    std::vector<value> b( nbw );
+    
+    m->kernels_.reserve( nkernels );
+    
+    for (unsigned int k=0; k<nkernels; ++k) {
+        
+        for (unsigned int d=0; d<ndim; ++d) { l[d] = kloc[d*nkernels + k]; }
+        for (unsigned int d=0; d<nbw; ++d) { b[d] = kbw[d*nkernels + k]; }
+        
+        m->kernels_.append( l.data(), b.data(), space->compute_scale_factor( b.data() ) );
     }
     
     return m;    
@@ -624,19 +1350,208 @@ std::unique_ptr<Mixture> Mixture::from_hdf5(const HighFive::Group & group) {
 PartialMixture::PartialMixture( const Mixture * source, const std::vector<bool> & selection, const value * points, unsigned int n ) :
 mixture_(*source), nsamples_(n), selection_(selection), inverted_selection_(selection) {        
     
-    partial_logp_.resize( mixture_.ncomponents() * nsamples_ );
-    mixture_.partial( points, nsamples_, selection_, partial_logp_.data() );
+    std::vector<value> logp( mixture_.ncomponents() * nsamples_ );
+    mixture_.partial( points, nsamples_, selection_, logp.data() );
+    set_partial_logp_( logp );
     inverted_selection_.flip();
+    complete_evaluator_ = make_evaluator( mixture_.space(), inverted_selection_ );
     partial_shape_ = { nsamples_ };
+    precompute_();
 }
 
-PartialMixture::PartialMixture( const Mixture * source, Grid & grid ) :
+PartialMixture::PartialMixture( const Mixture * source, const Grid & grid ) :
 mixture_(*source), nsamples_(grid.size()), selection_(source->space().specification().selection(grid.specification())), inverted_selection_(selection_) {        
     
-    partial_logp_.resize( mixture_.ncomponents() * nsamples_ );
-    mixture_.partial( grid, partial_logp_.data() );
+    set_factors_( grid );
+    
+    // evaluate one block of components at a time, blocks are independent
+    // and are built in parallel
+    unsigned int K = mixture_.ncomponents();
+    unsigned int n = row_size_();
+    
+    blocks_.resize( (K + PARTIAL_BLOCK_SIZE - 1) / PARTIAL_BLOCK_SIZE );
+    
+    parallel_for( mixture_.thread_pool(), blocks_.size(), [&]( unsigned int b, unsigned int ) {
+        
+        unsigned int c0 = b*PARTIAL_BLOCK_SIZE;
+        unsigned int nc = std::min( PARTIAL_BLOCK_SIZE, K-c0 );
+        
+        std::vector<unsigned int> components( nc );
+        std::iota( components.begin(), components.end(), c0 );
+        
+        std::vector<value> logp( nc * n );
+        evaluate_rows_( grid, components, logp.data() );
+        
+        auto block = std::make_shared<Block>();
+        for (unsigned int r=0; r<nc; ++r) {
+            append_row_( *block, logp.data() + r*n );
+        }
+        
+        blocks_[b] = block;
+    });
+    
+    inverted_selection_.flip();
+    complete_evaluator_ = make_evaluator( mixture_.space(), inverted_selection_ );
+    partial_shape_ = grid.shape();
+    precompute_();
+}
+
+PartialMixture::PartialMixture( const PartialMixture & previous, 
+    const Mixture * source, const Grid & grid, const MixtureChanges & changes ) :
+mixture_(*source), nsamples_(grid.size()), selection_(previous.selection_), 
+inverted_selection_(previous.inverted_selection_), 
+partial_shape_(previous.partial_shape_), 
+factor_sizes_(previous.factor_sizes_), factor_strides_(previous.factor_strides_) {
+    
+    if (changes.reset || previous.ncomponents()!=changes.ncomponents ||
+        previous.nsamples_!=nsamples_ || changes.ncomponents>mixture_.ncomponents()) {
+        throw std::runtime_error("Cannot update partial mixture for changes in source mixture.");
+    }
+    
+    // components that need to be evaluated
+    std::vector<unsigned int> components = changes.modified;
+    for (unsigned int c=changes.ncomponents; c<mixture_.ncomponents(); ++c) {
+        components.push_back( c );
+    }
+    
+    unsigned int n = row_size_();
+    std::vector<value> logp( components.size() * n );
+    
+    unsigned int nchunks = (components.size() + PARTIAL_BLOCK_SIZE - 1) / PARTIAL_BLOCK_SIZE;
+    
+    parallel_for( mixture_.thread_pool(), nchunks, [&]( unsigned int k, unsigned int ) {
+        std::vector<unsigned int> chunk( components.begin() + k*PARTIAL_BLOCK_SIZE,
+            components.begin() + std::min<size_t>( (k+1)*PARTIAL_BLOCK_SIZE, components.size() ) );
+        evaluate_rows_( grid, chunk, logp.data() + (size_t) k*PARTIAL_BLOCK_SIZE*n );
+    });
+    
+    // share unchanged blocks and rebuild blocks with changed components
+    blocks_ = previous.blocks_;
+    complete_log_scale_ = previous.complete_log_scale_;
+    complete_evaluator_ = previous.complete_evaluator_;
+    complete_locations_ = previous.complete_locations_;
+    complete_inverse_bandwidths_ = previous.complete_inverse_bandwidths_;
+    complete_log_scale_.resize( mixture_.ncomponents() );
+    
+    auto & kernels = mixture_.components();
+    unsigned int K = mixture_.ncomponents();
+    
+    if (complete_evaluator_) {
+        complete_locations_.resize( K*complete_evaluator_->ndim() );
+        complete_inverse_bandwidths_.resize( K*complete_evaluator_->ndim() );
+    }
+    
+    // components are sorted, so that each block is rebuilt once
+    unsigned int k = 0;
+    
+    while (k<components.size()) {
+        
+        unsigned int b = components[k]/PARTIAL_BLOCK_SIZE;
+        unsigned int nc = std::min( PARTIAL_BLOCK_SIZE, K - b*PARTIAL_BLOCK_SIZE );
+        
+        auto block = std::make_shared<Block>();
+        
+        for (unsigned int r=0; r<nc; ++r) {
+            
+            unsigned int c = b*PARTIAL_BLOCK_SIZE + r;
+            
+            if (k==components.size() || components[k]!=c) {
+                block->append( *previous.blocks_[b], r );
+                continue;
+            }
+            
+            unsigned int offset = block->logp.size();
+            append_row_( *block, logp.data() + k*n );
+            block->update_p( offset, factorized() );
+            
+            complete_log_scale_[c] = mixture_.space().compute_scale_factor( 
+                inverted_selection_.cbegin(), kernels.bandwidth(c), true );
+            
+            if (complete_evaluator_) {
+                unsigned int D = complete_evaluator_->ndim();
+                complete_evaluator_->gather( kernels.location(c), 
+                    kernels.inverse_bandwidth(c), 1, 
+                    complete_locations_.data() + c*D, 
+                    complete_inverse_bandwidths_.data() + c*D );
+            }
+            
+            ++k;
+        }
+        
+        if (b<blocks_.size()) {
+            blocks_[b] = block;
+        } else {
+            blocks_.push_back( block );
+        }
+    }
+}
+
+PartialMixture::PartialMixture( const Mixture * source, const Grid & grid, 
+    const std::vector<unsigned int> & factor_sizes,
+    const std::vector<unsigned int> & run_counts, 
+    const std::vector<unsigned int> & runs, const std::vector<value> & logp ) :
+mixture_(*source), nsamples_(grid.size()), selection_(source->space().specification().selection(grid.specification())), inverted_selection_(selection_) {
+    
+    set_factors_( grid );
+    
+    if (factor_sizes!=factor_sizes_ || run_counts.size()!=mixture_.ncomponents()) {
+        throw std::runtime_error("Saved partial mixture does not match mixture and grid.");
+    }
+    
+    size_t run = 0;
+    size_t offset = 0;
+    std::shared_ptr<Block> block;
+    
+    for (unsigned int c=0; c<run_counts.size(); ++c) {
+        
+        if (c%PARTIAL_BLOCK_SIZE==0) {
+            block = std::make_shared<Block>();
+            blocks_.push_back( block );
+        }
+        
+        if (factorized() && run_counts[c]!=factor_sizes_.size()) {
+            throw std::runtime_error("Cannot load partial mixture data.");
+        }
+        
+        unsigned int end = 0;
+        
+        for (unsigned int r=0; r<run_counts[c]; ++r, ++run) {
+            
+            if (2*run+1>=runs.size()) {
+                throw std::runtime_error("Cannot load partial mixture data.");
+            }
+            
+            Run item = { runs[2*run], runs[2*run+1] };
+            
+            // runs should be sorted and within grid (or factor)
+            unsigned int n = factorized() ? factor_sizes_[r] : nsamples_;
+            
+            if ((!factorized() && item.start<end) || item.start>n || 
+                item.size>n-item.start || item.size>logp.size()-offset) {
+                throw std::runtime_error("Cannot load partial mixture data.");
+            }
+            
+            end = item.start + item.size;
+            
+            block->runs.push_back( item );
+            block->logp.insert( block->logp.end(), logp.begin() + offset, 
+                logp.begin() + offset + item.size );
+            
+            offset += item.size;
+        }
+        
+        block->run_start.push_back( block->runs.size() );
+        block->value_start.push_back( block->logp.size() );
+    }
+    
+    if (2*run!=runs.size() || offset!=logp.size()) {
+        throw std::runtime_error("Cannot load partial mixture data.");
+    }
+    
     inverted_selection_.flip();
+    complete_evaluator_ = make_evaluator( mixture_.space(), inverted_selection_ );
     partial_shape_ = grid.shape();
+    precompute_();
 }
 
 // properties
@@ -645,7 +1560,7 @@ const Mixture & PartialMixture::mixture() const {
 }
     
 unsigned int PartialMixture::ncomponents() const {
-    return partial_logp_.size() / nsamples_;
+    return complete_log_scale_.size();
 }
 
 unsigned int PartialMixture::nsamples() const {
@@ -664,11 +1579,281 @@ const std::vector<long unsigned int> & PartialMixture::partial_shape() const {
     return partial_shape_;
 }
    
-const std::vector<value> & PartialMixture::partial_logp() const {
-    return partial_logp_;
+std::vector<value> PartialMixture::partial_logp() const {
+    
+    std::vector<value> logp( ncomponents() * nsamples_, 
+        -std::numeric_limits<value>::infinity() );
+    
+    if (factorized()) {
+        
+        // outer sum of factor terms
+        unsigned int D = factor_sizes_.size();
+        std::vector<std::vector<value>> terms( D );
+        
+        for (unsigned int c=0; c<ncomponents(); ++c) {
+            
+            auto row = row_(c);
+            const value * it = row.logp;
+            
+            for (unsigned int d=0; d<D; ++d) {
+                terms[d].assign( factor_sizes_[d], 
+                    -std::numeric_limits<value>::infinity() );
+                std::copy( it, it + row.begin[d].size, 
+                    terms[d].begin() + row.begin[d].start );
+                it += row.begin[d].size;
+            }
+            
+            add_assign_vectors( terms, nsamples_, 0., logp.data() + c*nsamples_ );
+        }
+        
+        return logp;
+    }
+    
+    for (unsigned int c=0; c<ncomponents(); ++c) {
+        
+        auto row = row_(c);
+        const value * it = row.logp;
+        
+        for (auto run = row.begin; run!=row.end; ++run) {
+            std::copy( it, it + run->size, logp.begin() + c*nsamples_ + run->start );
+            it += run->size;
+        }
+    }
+    
+    return logp;
 }
 
 // methods
+void PartialMixture::precompute_() {
+    
+    auto & components = mixture_.components();
+    
+    complete_log_scale_.resize( components.size() );
+    
+    for (unsigned int c=0; c<components.size(); ++c) {
+        complete_log_scale_[c] = mixture_.space().compute_scale_factor( 
+            inverted_selection_.cbegin(), components.bandwidth(c), true );
+    }
+    
+    if (complete_evaluator_) {
+        
+        unsigned int D = complete_evaluator_->ndim();
+        complete_locations_.resize( components.size()*D );
+        complete_inverse_bandwidths_.resize( components.size()*D );
+        
+        for (unsigned int b=0, c=0; b<components.nblocks(); ++b) {
+            complete_evaluator_->gather( components.block_locations(b), 
+                components.block_inverse_bandwidths(b), components.block_size(b),
+                complete_locations_.data() + c*D, 
+                complete_inverse_bandwidths_.data() + c*D );
+            c += components.block_size(b);
+        }
+    }
+    
+    parallel_for( mixture_.thread_pool(), blocks_.size(), [&]( unsigned int b, unsigned int ) {
+        // blocks are not shared yet
+        std::const_pointer_cast<Block>( blocks_[b] )->update_p( 0, factorized() );
+    });
+}
+
+void PartialMixture::set_factors_( const Grid & grid ) {
+    
+    factor_sizes_ = grid.factor_sizes( mixture_.space() );
+    
+    unsigned int N = std::accumulate( factor_sizes_.begin(), 
+        factor_sizes_.end(), 1u, std::multiplies<unsigned int>() );
+    
+    if (factor_sizes_.size()<2 || factor_sizes_.size()>MAX_GRID_FACTORS || 
+        N!=nsamples_) {
+        factor_sizes_.clear();
+        factor_strides_.clear();
+        return;
+    }
+    
+    factor_strides_.resize( factor_sizes_.size() );
+    
+    unsigned int stride = 1;
+    for (int d=factor_sizes_.size()-1; d>=0; --d) {
+        factor_strides_[d] = stride;
+        stride *= factor_sizes_[d];
+    }
+}
+
+unsigned int PartialMixture::row_size_() const {
+    if (factorized()) {
+        return std::accumulate( factor_sizes_.begin(), factor_sizes_.end(), 0u );
+    }
+    return nsamples_;
+}
+
+void PartialMixture::evaluate_rows_( const Grid & grid, 
+    const std::vector<unsigned int> & components, value * logp ) const {
+    
+    if (factorized()) {
+        mixture_.partial_factors( grid, components, logp );
+    } else {
+        mixture_.partial( grid, components, logp );
+    }
+}
+
+void PartialMixture::append_row_( Block & block, const value * logp ) const {
+    
+    if (factorized()) {
+        block.append( logp, factor_sizes_ );
+    } else {
+        block.append( logp, nsamples_ );
+    }
+}
+
+void PartialMixture::rows_( std::vector<unsigned int> & run_counts, 
+    std::vector<unsigned int> & runs, std::vector<value> & logp ) const {
+    
+    run_counts.clear();
+    runs.clear();
+    logp.clear();
+    
+    for (auto & block : blocks_) {
+        for (unsigned int r=0; r<block->nrows(); ++r) {
+            
+            run_counts.push_back( block->run_start[r+1] - block->run_start[r] );
+            
+            for (unsigned int k=block->run_start[r]; k<block->run_start[r+1]; ++k) {
+                runs.push_back( block->runs[k].start );
+                runs.push_back( block->runs[k].size );
+            }
+            
+            logp.insert( logp.end(), block->logp.begin() + block->value_start[r],
+                block->logp.begin() + block->value_start[r+1] );
+        }
+    }
+}
+
+void PartialMixture::set_partial_logp_( const std::vector<value> & logp ) {
+    
+    unsigned int K = logp.size() / nsamples_;
+    
+    blocks_.clear();
+    
+    for (unsigned int c0=0; c0<K; c0+=PARTIAL_BLOCK_SIZE) {
+        auto block = std::make_shared<Block>();
+        for (unsigned int c=c0; c<std::min( c0+PARTIAL_BLOCK_SIZE, K ); ++c) {
+            block->append( logp.data() + c*nsamples_, nsamples_ );
+        }
+        blocks_.push_back( block );
+    }
+}
+
+void PartialMixture::Block::append( const value * values, unsigned int n ) {
+    
+    unsigned int s = 0;
+    
+    while (s<n) {
+        
+        // skip samples outside support
+        while (s<n && std::isinf(values[s])) { ++s; }
+        
+        unsigned int start = s;
+        
+        while (s<n && !std::isinf(values[s])) { ++s; }
+        
+        if (s>start) {
+            runs.push_back( { start, s-start } );
+            logp.insert( logp.end(), values + start, values + s );
+        }
+    }
+    
+    run_start.push_back( runs.size() );
+    value_start.push_back( logp.size() );
+}
+
+void PartialMixture::Block::append( const value * values, 
+    const std::vector<unsigned int> & factor_sizes ) {
+    
+    for (auto & n : factor_sizes) {
+        
+        // range of support of factor, such that each factor has 
+        // exactly one run
+        unsigned int start = 0;
+        unsigned int end = n;
+        
+        while (start<end && std::isinf(values[start])) { ++start; }
+        while (end>start && std::isinf(values[end-1])) { --end; }
+        
+        runs.push_back( { start, end-start } );
+        logp.insert( logp.end(), values + start, values + end );
+        
+        values += n;
+    }
+    
+    run_start.push_back( runs.size() );
+    value_start.push_back( logp.size() );
+}
+
+void PartialMixture::Block::update_p( unsigned int offset, bool exact ) {
+    
+    p.resize( logp.size() );
+    
+    if (exact) {
+        std::transform( logp.begin() + offset, logp.end(), p.begin() + offset, 
+            [](const value & a) { return std::exp(a); } );
+        return;
+    }
+    
+    fastexp_n( logp.data() + offset, p.data() + offset, logp.size() - offset );
+    
+    // fast exponential is not exactly zero outside support
+    for (unsigned int k=offset; k<logp.size(); ++k) {
+        if (std::isinf(logp[k])) { p[k] = 0.; }
+    }
+}
+
+void PartialMixture::Block::append( const Block & other, unsigned int r ) {
+    
+    runs.insert( runs.end(), other.runs.begin() + other.run_start[r], 
+        other.runs.begin() + other.run_start[r+1] );
+    logp.insert( logp.end(), other.logp.begin() + other.value_start[r], 
+        other.logp.begin() + other.value_start[r+1] );
+    p.insert( p.end(), other.p.begin() + other.value_start[r], 
+        other.p.begin() + other.value_start[r+1] );
+    
+    run_start.push_back( runs.size() );
+    value_start.push_back( logp.size() );
+}
+
+void PartialMixture::update_marginal( const PartialMixture & previous, 
+    const MixtureChanges & changes, value * result ) const {
+    
+    // weights of all existing components were scaled
+    value scale = changes.weight_scale;
+    
+    std::transform( result, result + nsamples_, result, 
+        [scale](const value & a) { return a * scale; } );
+    
+    auto & mixture = mixture_;
+    auto & previous_mixture = previous.mixture_;
+    
+    auto add_row = [result]( const PartialMixture & pm, unsigned int c, value w ) {
+        pm.for_each_segment_( c, [result,w]( unsigned int start, value scale, 
+            const value * p, unsigned int n ) {
+            scale *= w;
+            for (unsigned int s=0; s<n; ++s) {
+                result[start+s] += scale * p[s];
+            }
+        });
+    };
+    
+    // replace contribution of modified components
+    for (auto & c : changes.modified) {
+        add_row( previous, c, -scale * previous_mixture.weight(c) );
+        add_row( *this, c, mixture.weight(c) );
+    }
+    
+    // add contribution of appended components
+    for (unsigned int c=changes.ncomponents; c<mixture.ncomponents(); ++c) {
+        add_row( *this, c, mixture.weight(c) );
+    }
+}
+
 void PartialMixture::complete ( const value * points, unsigned int n, value * result ) const {
     
     if (ncomponents() != mixture().ncomponents()) {
@@ -682,88 +1867,279 @@ void PartialMixture::complete ( const value * points, unsigned int n, value * re
     
     unsigned int ndim = std::count( inverted_selection_.begin(), inverted_selection_.end(), true );
     
-    auto w = mixture_.weights().cbegin();
-    auto it = partial_logp_.cbegin();
+    auto & components = mixture_.components();
+    value w;
+    
+    std::vector<value> xs( complete_evaluator_ ? n : 0 );
     
-    for (auto & c : mixture_.components()) {
+    for (unsigned int c=0; c<components.size(); ++c) {
         
-        scale = mixture_.space().compute_scale_factor( *c, inverted_selection_, true );
+        scale = complete_log_scale_[c];
+        w = mixture_.weight(c);
         
         ptr = points;
         presult = result;
         
+        if (complete_evaluator_) {
+            complete_evaluator_->partial_logp( components.location(c), 
+                components.inverse_bandwidth(c), points, n, ndim, xs.data() );
+        }
+        
         for (unsigned int k=0; k<n; ++k) {
             
-            x = mixture_.space().partial_logp( *c, ptr, inverted_selection_) + scale;
+            if (complete_evaluator_) {
+                x = xs[k] + scale;
+            } else {
+                x = mixture_.space().partial_logp( components.location(c), 
+                    components.bandwidth(c), ptr, inverted_selection_.cbegin() ) + scale;
+            }
             
             ptr += ndim;
             
-            if (std::isinf(x)) { presult+=nsamples_; continue; }
-            
-            for (unsigned int s=0; s<nsamples_; ++s) {
+            if (!std::isinf(x)) {
                 
-                if (std::isinf(it[s])) { ++presult; continue; }
+                // only samples in the support of the component contribute
+                value a = w * fastexp( x );
                 
-                *presult++ += (*w) * fastexp(it[s] + x);
+                for_each_segment_( c, [presult,a]( unsigned int start, 
+                    value scale, const value * p, unsigned int n ) {
+                    scale *= a;
+                    for (unsigned int s=0; s<n; ++s) {
+                        presult[start+s] += scale * p[s];
+                    }
+                });
             }
             
+            presult += nsamples_;
         }
         
-        ++w;
-        it+=nsamples_;
-        
     }
     
 }
 
-void PartialMixture::complete_multi ( const value * points, unsigned int n, value * result ) const { //, value * offset ) const {
+void PartialMixture::complete_block_( const value * points, unsigned int n, 
+    std::vector<value> & A, value * result ) const {
     
-    if (ncomponents() != mixture().ncomponents()) {
-        throw std::runtime_error("Number of kernels in source mixture has changed.");
-    }
+    auto & components = mixture_.components();
+    unsigned int K = components.size();
     
-    value x=0;
-    value scale;
-    const value * ptr = points;
+    unsigned int ndim = std::count( inverted_selection_.begin(), inverted_selection_.end(), true );
     
-    std::vector<value> tmp(nsamples_);
+    // weight matrix A [n x K]
+    A.resize( n*K );
     
-    unsigned int ndim = std::count( inverted_selection_.begin(), inverted_selection_.end(), true );
+    std::vector<value> x(K);
+    value * row_a;
+    const value * ptr = points;
     
-    for (unsigned int k=0; k<n; ++k) {
+    auto & space = mixture_.space();
+    
+    for (unsigned int e=0; e<n; ++e) {
         
-        auto it = partial_logp_.cbegin();
-        auto w = mixture_.weights().cbegin();
+        row_a = A.data() + e*K;
         
-        std::fill( tmp.begin(), tmp.end(), 0. );
+        if (complete_evaluator_) {
+            complete_evaluator_->partial_logp_gathered( complete_locations_.data(), 
+                complete_inverse_bandwidths_.data(), K, ptr, x.data() );
+        }
         
-        for (auto & c : mixture_.components()) {
-            
-            x = mixture_.space().partial_logp( *c, ptr, inverted_selection_);
-            if (std::isinf(x)) { it+=nsamples_; ++w; continue; }
-            
-            scale = mixture_.space().compute_scale_factor( *c, inverted_selection_, true );
-            x += scale;
-            
-            for (unsigned int s=0; s<nsamples_; ++s) {
-                tmp[s] += (*w) * fastexp(*it + x);
-                ++it;
+        for (unsigned int b=0, c=0; b<components.nblocks() && !complete_evaluator_; ++b) {
+            const value * loc = components.block_locations(b);
+            const value * bw = components.block_bandwidths(b);
+            for (unsigned int k=components.block_size(b); k>0; --k, ++c) {
+                x[c] = space.partial_logp( loc, bw, ptr, inverted_selection_.cbegin() );
+                loc += components.ndim();
+                bw += components.nbw();
             }
-            
-            ++w;
-            
+        }
+        
+        std::transform( x.begin(), x.end(), complete_log_scale_.begin(), row_a, 
+            std::plus<value>() );
+        fastexp_n( row_a, row_a, K );
+        
+        // components with zero probability are skipped in product
+        for (unsigned int c=0; c<K; ++c) {
+            row_a[c] = std::isinf(x[c]) ? 0. : mixture_.weight(c) * row_a[c];
         }
         
         ptr += ndim;
-               
-        // add offset
-        //if (offset!=nullptr) {
-        //   std::transform( tmp.begin(), tmp.end(), offset, tmp.begin(), std::plus<value>() );
-        //}
+    }
+    
+    std::fill( result, result + n*nsamples_, 0. );
+    
+    // tiled product, such that result tile stays in cache while
+    // the rows of partial p are streamed, only the part of the support 
+    // of each component that overlaps with the tile is visited
+    // (factorized rows are tiled along whole segments of the last factor)
+    unsigned int tile = COMPLETE_SAMPLE_BLOCK;
+    if (factorized()) {
+        tile = std::max( 1u, tile/factor_sizes_.back() ) * factor_sizes_.back();
+    }
+    
+    for (unsigned int s0=0; s0<nsamples_; s0+=tile) {
+        
+        unsigned int s1 = std::min( s0 + tile, nsamples_ );
+        
+        for (unsigned int c=0; c<K; ++c) {
+            
+            for_each_segment_( c, [&]( unsigned int start, value scale, 
+                const value * p, unsigned int m ) {
+                
+                for (unsigned int e=0; e<n; ++e) {
+                    
+                    value a = A[e*K+c];
+                    if (a==0.) { continue; }
+                    
+                    a *= scale;
+                    value * out = result + e*nsamples_ + start;
+                    
+                    for (unsigned int s=0; s<m; ++s) {
+                        out[s] += a * p[s];
+                    }
+                }
+            }, s0, s1 );
+        }
+    }
+}
+
+void PartialMixture::complete_events ( const value * points, unsigned int n, value * result ) const {
+    
+    if (ncomponents() != mixture().ncomponents()) {
+        throw std::runtime_error("Number of kernels in source mixture has changed.");
+    }
+    
+    unsigned int ndim = std::count( inverted_selection_.begin(), inverted_selection_.end(), true );
+    
+    std::vector<value> A;
+    
+    for (unsigned int k=0; k<n; k+=COMPLETE_EVENT_BLOCK) {
+        
+        unsigned int nb = std::min( COMPLETE_EVENT_BLOCK, n-k );
+        
+        complete_block_( points + k*ndim, nb, A, result + k*nsamples_ );
+    }
+    
+    fastlog_n( result, result, n*nsamples_ );
+}
+
+void PartialMixture::complete_multi ( const value * points, unsigned int n, value * result ) const { //, value * offset ) const {
+    
+    if (ncomponents() != mixture().ncomponents()) {
+        throw std::runtime_error("Number of kernels in source mixture has changed.");
+    }
+    
+    unsigned int ndim = std::count( inverted_selection_.begin(), inverted_selection_.end(), true );
+    
+    std::vector<value> A;
+    std::vector<value> tmp( COMPLETE_EVENT_BLOCK * nsamples_ );
+    
+    for (unsigned int k=0; k<n; k+=COMPLETE_EVENT_BLOCK) {
+        
+        unsigned int nb = std::min( COMPLETE_EVENT_BLOCK, n-k );
+        
+        complete_block_( points + k*ndim, nb, A, tmp.data() );
         
         // add log of temporary vector to result
-        std::transform( tmp.begin(), tmp.end(), result, result, [](const value & a, const value & b) { return fastlog(a) + b; } );
+        fastlog_n( tmp.data(), tmp.data(), nb*nsamples_ );
+        
+        for (unsigned int e=0; e<nb; ++e) {
+            std::transform( tmp.begin() + e*nsamples_, tmp.begin() + (e+1)*nsamples_, 
+                result, result, std::plus<value>() );
+        }
     }
     
 }
 
+// flatbuffers
+flatbuffers::Offset<fb_serialize::PartialMixture> PartialMixture::to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const {
+    
+    std::vector<unsigned int> run_counts;
+    std::vector<unsigned int> runs;
+    std::vector<value> logp;
+    
+    rows_( run_counts, runs, logp );
+    
+    return fb_serialize::CreatePartialMixture(
+        builder,
+        nsamples_,
+        builder.CreateVector(factor_sizes_),
+        builder.CreateVector(run_counts),
+        builder.CreateVector(runs),
+        builder.CreateVector(logp)
+    );
+}
+
+std::unique_ptr<PartialMixture> PartialMixture::from_flatbuffers( 
+    const fb_serialize::PartialMixture * partial, const Mixture * source, 
+    const Grid & grid ) {
+    
+    if (partial->nsamples()!=grid.size()) {
+        throw std::runtime_error("Saved partial mixture does not match grid.");
+    }
+    
+    std::vector<unsigned int> factor_sizes;
+    if (partial->factor_sizes()) {
+        factor_sizes.assign( partial->factor_sizes()->begin(), partial->factor_sizes()->end() );
+    }
+    
+    std::vector<unsigned int> run_counts( partial->run_counts()->begin(), partial->run_counts()->end() );
+    std::vector<unsigned int> runs( partial->runs()->begin(), partial->runs()->end() );
+    std::vector<value> logp( partial->logp()->begin(), partial->logp()->end() );
+    
+    return std::unique_ptr<PartialMixture>( new PartialMixture( source, grid, 
+        factor_sizes, run_counts, runs, logp ) );
+}
+
+// hdf5
+void PartialMixture::to_hdf5(HighFive::Group & group) const {
+    
+    std::vector<unsigned int> run_counts;
+    std::vector<unsigned int> runs;
+    std::vector<value> logp;
+    
+    rows_( run_counts, runs, logp );
+    
+    HighFive::DataSet ds_n = group.createDataSet<unsigned int>("nsamples", HighFive::DataSpace::From(nsamples_));
+    ds_n.write(nsamples_);
+    
+    if (factorized()) {
+        HighFive::DataSet ds_f = group.createDataSet<unsigned int>("factor_sizes", HighFive::DataSpace::From(factor_sizes_));
+        ds_f.write(factor_sizes_);
+    }
+    
+    HighFive::DataSet ds_c = group.createDataSet<unsigned int>("run_counts", HighFive::DataSpace::From(run_counts));
+    ds_c.write(run_counts);
+    
+    HighFive::DataSet ds_r = group.createDataSet<unsigned int>("runs", HighFive::DataSpace::From(runs));
+    ds_r.write(runs);
+    
+    HighFive::DataSet ds_l = group.createDataSet<value>("logp", HighFive::DataSpace::From(logp));
+    ds_l.write(logp);
+}
+
+std::unique_ptr<PartialMixture> PartialMixture::from_hdf5( const HighFive::Group & group,
+    const Mixture * source, const Grid & grid ) {
+    
+    unsigned int nsamples;
+    group.getDataSet("nsamples").read(nsamples);
+    
+    if (nsamples!=grid.size()) {
+        throw std::runtime_error("Saved partial mixture does not match grid.");
+    }
+    
+    std::vector<unsigned int> factor_sizes;
+    if (group.exist("factor_sizes")) {
+        group.getDataSet("factor_sizes").read(factor_sizes);
+    }
+    
+    std::vector<unsigned int> run_counts;
+    std::vector<unsigned int> runs;
+    std::vector<value> logp;
+    
+    group.getDataSet("run_counts").read(run_counts);
+    group.getDataSet("runs").read(runs);
+    group.getDataSet("logp").read(logp);
+    
+    return std::unique_ptr<PartialMixture>( new PartialMixture( source, grid, 
+        factor_sizes, run_counts, runs, logp ) );
+}
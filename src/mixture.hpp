@@ -19,15 +19,61 @@
 #pragma once
 
 #include "space.hpp"
+#include "evaluator.hpp"
+#include "threadpool.hpp"
+#include "spatial_index.hpp"
+#include "mapped_file.hpp"
 #include "schema_generated.h"
 
 #include <vector>
 #include <memory>
+#include <limits>
 
 static const value THRESHOLD = 1.;
 
+// range of the global weight scale factor in Mixture, outside of which
+// the factor is folded into the component weights
+static const value MIN_WEIGHT_SCALE = 1e-100;
+static const value MAX_WEIGHT_SCALE = 1e100;
+
+// block sizes for matrix product in PartialMixture::complete_multi
+static const unsigned int COMPLETE_EVENT_BLOCK = 8;
+static const unsigned int COMPLETE_SAMPLE_BLOCK = 256;
+// number of components per block of rows in PartialMixture
+static const unsigned int PARTIAL_BLOCK_SIZE = 64;
+// maximum number of factors of a separable grid for which PartialMixture
+// stores the per factor terms rather than the full grid
+static const unsigned int MAX_GRID_FACTORS = 8;
+// when the bounds on the size of a mixture are exceeded, components are
+// pruned down to this fraction of max_components and components with a 
+// weight below min_weight divided by this fraction are removed, so that
+// pruning (which resets change tracking) is not needed after every update
+static const value PRUNE_HYSTERESIS = 0.9;
+// average number of components per cell of the spatial index used in
+// reduction (cells are enlarged as the number of components drops)
+static const value REDUCE_CELL_OCCUPANCY = 1.;
+// number of components per task in parallel evaluation on a grid
+static const unsigned int PARALLEL_COMPONENT_BLOCK = 64;
+// number of components per chunk and compression level of component 
+// datasets in hdf5 files
+static const unsigned int HDF5_CHUNK_COMPONENTS = 4096;
+static const unsigned int HDF5_DEFLATE_LEVEL = 4;
+
 class PartialMixture;
 
+// changes of a mixture since the last call to Mixture::clear_changes
+struct MixtureChanges {
+    // number of components at the time of the last clear_changes,
+    // components with a larger index were appended
+    unsigned int ncomponents = 0;
+    // existing components that were merged with new samples (sorted)
+    std::vector<unsigned int> modified;
+    // factor that was applied to the weights of all existing components
+    value weight_scale = 1.;
+    // mixture was cleared
+    bool reset = false;
+};
+
 class Mixture {
 public:
     // constructor
@@ -38,8 +84,9 @@ public:
     void clear();
     
     // properties
-    const std::vector<value> & weights() const;
-    const std::vector<std::unique_ptr<Component>> & components() const;
+    std::vector<value> weights() const;
+    value weight( unsigned int c ) const { return weights_[c] * weight_scale_; }
+    const ComponentStore & components() const;
         
     value sum_of_weights() const;
     value sum_of_nsamples() const;
@@ -50,20 +97,63 @@ public:
     
     void set_threshold( value v );
     
+    // bounds on the size of the mixture, components with a weight below 
+    // min_weight and the lowest weight components in excess of 
+    // max_components are removed after new samples are added
+    // (0 means no bound). Pruning removes a margin of extra components,
+    // see PRUNE_HYSTERESIS.
+    unsigned int max_components() const;
+    value min_weight() const;
+    
+    void set_max_components( unsigned int n );
+    void set_min_weight( value v );
+    
+    // worker threads for evaluation on grids (0 means one per core), the
+    // thread pool is shared with copies of the mixture
+    unsigned int nthreads() const;
+    void set_nthreads( unsigned int n );
+    ThreadPool * thread_pool() const { return pool_.get(); }
+    // use another thread pool (nullptr for serial evaluation)
+    void set_thread_pool( std::shared_ptr<ThreadPool> pool );
+    
+    // change tracking for incremental updates of derived quantities
+    MixtureChanges changes() const;
+    void clear_changes();
+    
+    // fingerprint of components and weights, to check that persisted 
+    // derived quantities belong to the mixture
+    uint64_t fingerprint() const;
+    
     // methods
     void add_samples( const value * samples, unsigned int n, value w=1., value attenuation=1. );
     void merge_samples( const value * samples, unsigned int n, bool random = true, value w=1., value attenuation=1. );
     
+    // merge components of other mixture (in the same space), weights of both 
+    // mixtures are combined according to their sum of weights
+    void merge_mixture( const Mixture & other );
+    
+    // greedily merge the closest pairs of components until at most 
+    // ncomponents remain
+    void reduce( unsigned int ncomponents );
+    // greedily merge the closest pairs of components that are within the 
+    // new compression threshold, which is used for subsequent merges
+    void reduce_threshold( value threshold );
+    
     void evaluate( const value * points, unsigned int n, value * result );
-    void evaluate( Grid & grid, value * result ) const;
+    void evaluate( const Grid & grid, value * result ) const;
     
     void partial( const value * points, unsigned int n, const std::vector<bool> & selection, value * result ) const;
     PartialMixture* partial( const value * points, unsigned int n, const std::vector<bool> & selection) const;
-    void partial( Grid & grid, value * result ) const;
-    PartialMixture* partial( Grid & grid ) const;
+    void partial( const Grid & grid, value * result ) const;
+    PartialMixture* partial( const Grid & grid ) const;
+    // partial log probability of selected components only
+    void partial( const Grid & grid, const std::vector<unsigned int> & components, value * result ) const;
+    // per factor partial log probability terms of selected components for 
+    // separable grid (see Grid::factor_sizes)
+    void partial_factors( const Grid & grid, const std::vector<unsigned int> & components, value * result ) const;
     
     void marginal( const value * points, unsigned int n, const std::vector<bool> & selection, value * result ) const;
-    void marginal( Grid & grid, value * result ) const;
+    void marginal( const Grid & grid, value * result ) const;
     
     //void partial( const Grid * grid, const std::vector<bool> & selection, value * result ) const {
         //// grid space has to be subspace of mixture space
@@ -86,8 +176,15 @@ public:
     static std::unique_ptr<Mixture> load_from_yaml( std::string path );
     
     // flatbuffers
+    // if owner is set, component locations and bandwidths are used in place
+    // (without copy) and the buffer is kept alive by owner
     flatbuffers::Offset<fb_serialize::Mixture> to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const;
-    static std::unique_ptr<Mixture> from_flatbuffers(const fb_serialize::Mixture * mixture);
+    static std::unique_ptr<Mixture> from_flatbuffers(const fb_serialize::Mixture * mixture,
+        std::shared_ptr<const void> owner = nullptr);
+    
+    void save_to_flatbuffers_file( std::string filename ) const;
+    // memory-maps file, components refer to the mapped data until modified
+    static std::unique_ptr<Mixture> load_from_flatbuffers_file( std::string filename );
 
     // hdf5
     void to_hdf5(HighFive::Group & group) const;
@@ -101,11 +198,45 @@ public:
         std::string path="");
     
 protected:
+    // chunked and compressed layout of datasets with one column per 
+    // component (the last dimension)
+    static HighFive::DataSetCreateProps component_dataset_props_( 
+        const std::vector<size_t> & dims );
+    
     value update_weights_( unsigned int nsamples );
     value update_weights_( unsigned int nsamples, value weight, value attenuation );
+    // multiply weights of all existing components
+    void scale_weights_( value factor );
+    
+    // merge component (with absolute weight) into closest component within 
+    // threshold, or append as new component
+    void merge_component_( const value * loc, const value * bw, 
+        value scale_factor, value weight );
+    void append_component_( const value * loc, const value * bw, 
+        value scale_factor, value weight );
+    
+    // remove components that violate the size bounds and redistribute 
+    // their weight over the remaining components
+    void prune_();
+    // remove components (indices sorted, ascending), returns removed weight 
+    // relative to weight_scale_
+    value remove_components_( const std::vector<unsigned int> & indices );
+    
+    // merge pairs of components in order of increasing distance, until at 
+    // most ncomponents remain and no pair is closer than threshold
+    void reduce_( unsigned int ncomponents, value threshold_squared );
     
-    bool closest( const Component & c, unsigned int & index, value threshold_squared) const;
-    bool closest( const Component & c, unsigned int & index ) const;
+    bool closest( const value * loc, unsigned int & index, value threshold_squared) const;
+    bool closest( const value * loc, unsigned int & index ) const;
+    
+    // (re)build spatial index if it is out of sync with components
+    void sync_index_();
+    
+    // sum of fcn( c, out, worker ) over all components into result (which 
+    // is not cleared first), components are evaluated in parallel blocks with 
+    // per worker sums that are added to result in a fixed order
+    void accumulate_( unsigned int n, value * result, const std::function<void(
+        unsigned int, value *, unsigned int)> & fcn ) const;
     
 protected:
     value sum_of_weights_;
@@ -114,8 +245,26 @@ protected:
     value threshold_squared_;
     
     std::unique_ptr<Space> space_;
-    std::vector<std::unique_ptr<Component>> kernels_;
+    // specialized evaluator for the full space (nullptr if not available)
+    std::shared_ptr<const Evaluator> evaluator_;
+    ComponentStore kernels_;
+    // component weights are weights_[c] * weight_scale_, such that
+    // rescaling of all weights is a single multiplication
     std::vector<value> weights_;
+    value weight_scale_;
+    
+    unsigned int max_components_;
+    value min_weight_;
+    // lower bound on weights_, such that the search for components below 
+    // min_weight can be skipped
+    value min_relative_weight_;
+    
+    std::unique_ptr<SpatialIndex> index_;
+    mutable std::vector<unsigned int> candidates_;
+    
+    std::shared_ptr<ThreadPool> pool_;
+    
+    MixtureChanges changes_;
 };
 
 
@@ -123,7 +272,22 @@ class PartialMixture {
 public:
     // constructors
     PartialMixture( const Mixture * source, const std::vector<bool> & selection, const value * points, unsigned int n );
-    PartialMixture( const Mixture * source, Grid & grid );
+    PartialMixture( const Mixture * source, const Grid & grid );
+    // update of partial mixture for changes in source mixture, only modified 
+    // and appended components are evaluated on the grid
+    PartialMixture( const PartialMixture & previous, const Mixture * source, 
+        const Grid & grid, const MixtureChanges & changes );
+    
+    // persistence of partial mixture on grid, the source mixture and grid 
+    // are not saved and should be the same when loading
+    flatbuffers::Offset<fb_serialize::PartialMixture> to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const;
+    static std::unique_ptr<PartialMixture> from_flatbuffers( 
+        const fb_serialize::PartialMixture * partial, const Mixture * source, 
+        const Grid & grid );
+    
+    void to_hdf5(HighFive::Group & group) const;
+    static std::unique_ptr<PartialMixture> from_hdf5( const HighFive::Group & group,
+        const Mixture * source, const Grid & grid );
     
     // properties
     const Mixture & mixture() const;
@@ -135,27 +299,40 @@ public:
     
     const std::vector<long unsigned int> & partial_shape() const;
     
-    const std::vector<value> & partial_logp() const;
+    std::vector<value> partial_logp() const;
     
     // methods
     void complete ( const value * points, unsigned int n, value * result ) const;
     void complete_multi ( const value * points, unsigned int n, value * result) const; //, value * offset = nullptr ) const;
+    // per event log probability, result has size [n x nsamples]
+    void complete_events ( const value * points, unsigned int n, value * result ) const;
         
+    // partial mixture over separable grid is stored in factorized form
+    bool factorized() const { return !factor_sizes_.empty(); }
+    
     template <class result_it>
     void marginal(result_it result) {
         
-        auto it = partial_logp_.cbegin();
-        
-        for (auto & w : mixture_.weights()) {
+        for (unsigned int c=0; c<mixture_.ncomponents(); ++c) {
             
-            for (unsigned int s=0; s<nsamples_; ++s) {
-                result[s] += w * fastexp(*it);
-                ++it;
-            }
+            value w = mixture_.weight(c);
+            
+            for_each_segment_( c, [&]( unsigned int start, value scale, 
+                const value * p, unsigned int n ) {
+                scale *= w;
+                for (unsigned int s=0; s<n; ++s) {
+                    result[start+s] += scale * p[s];
+                }
+            });
         }
         
     }
     
+    // update marginal of previous partial mixture for changes in source mixture,
+    // where this partial mixture was derived from previous with the same changes
+    void update_marginal( const PartialMixture & previous, 
+        const MixtureChanges & changes, value * result ) const;
+    
     // space
     const Space & space() const { return mixture_.space(); }
 
@@ -167,6 +344,172 @@ protected:
     unsigned int nsamples_;
     std::vector<bool> selection_;
     std::vector<bool> inverted_selection_;
-    std::vector<value> partial_logp_;
     std::vector<long unsigned int> partial_shape_;
+    
+    // log scale factors for completion (inverted selection) of each component
+    std::vector<value> complete_log_scale_;
+    // specialized evaluator for completion (nullptr if not available)
+    std::shared_ptr<const Evaluator> complete_evaluator_;
+    // locations and inverse bandwidths of the completion dimensions of all 
+    // components, gathered into contiguous [K x D] arrays for the evaluator
+    std::vector<value> complete_locations_;
+    std::vector<value> complete_inverse_bandwidths_;
+    
+    // rows of the [K x nsamples] partial log probability matrix and its 
+    // exponent (for the matrix product in complete_multi) are stored
+    // sparsely, as runs of consecutive samples with finite log probability
+    // (i.e. the support of the component). Rows are stored in blocks of 
+    // PARTIAL_BLOCK_SIZE components, which are shared with partial mixtures 
+    // that are derived from this one
+    // For a separable grid, a row instead holds the terms of each factor
+    // (such that the row has size G1+G2+... rather than G1*G2*...), with one 
+    // run per factor for the range of the factor's support, and the full row 
+    // is the outer sum (logp) or outer product (p) of the factor terms
+    struct Run {
+        unsigned int start;
+        unsigned int size;
+    };
+    struct Block {
+        // runs of row r are runs[run_start[r]] to runs[run_start[r+1]] and
+        // the values of all runs of row r start at value_start[r]
+        std::vector<unsigned int> run_start = {0};
+        std::vector<unsigned int> value_start = {0};
+        std::vector<Run> runs;
+        std::vector<value> logp;
+        std::vector<value> p;
+        
+        unsigned int nrows() const { return run_start.size()-1; }
+        // append row from dense log probability vector, p is not computed
+        void append( const value * logp, unsigned int n );
+        // append factorized row from consecutive factor terms
+        void append( const value * logp, const std::vector<unsigned int> & factor_sizes );
+        // append (logp and p of) row r of other block
+        void append( const Block & other, unsigned int r );
+        // compute p for values starting at offset (with exact rather than 
+        // fast exponential for the few values of factorized rows)
+        void update_p( unsigned int offset = 0, bool exact = false );
+    };
+    std::vector<std::shared_ptr<const Block>> blocks_;
+    
+    // sizes and strides of the factors of a separable grid 
+    // (empty if rows are not factorized)
+    std::vector<unsigned int> factor_sizes_;
+    std::vector<unsigned int> factor_strides_;
+    
+    struct Row {
+        const Run * begin;
+        const Run * end;
+        const value * logp;
+        const value * p;
+    };
+    Row row_( unsigned int c ) const {
+        auto & block = *blocks_[c/PARTIAL_BLOCK_SIZE];
+        unsigned int r = c%PARTIAL_BLOCK_SIZE;
+        return { block.runs.data() + block.run_start[r], 
+            block.runs.data() + block.run_start[r+1],
+            block.logp.data() + block.value_start[r],
+            block.p.data() + block.value_start[r] };
+    }
+    
+    // calls f( start, scale, p, n ) for each contiguous segment of the 
+    // support of row c that overlaps with samples s0 to s1 (clipped to 
+    // that range), such that the row equals scale * p[0:n] at samples
+    // start to start+n
+    template <class F>
+    void for_each_segment_( unsigned int c, F f, unsigned int s0 = 0, 
+        unsigned int s1 = std::numeric_limits<unsigned int>::max() ) const {
+        
+        s1 = std::min( s1, nsamples_ );
+        
+        auto row = row_(c);
+        const value * p = row.p;
+        
+        if (!factorized()) {
+            for (auto run = row.begin; run!=row.end; ++run) {
+                unsigned int lo = std::max( run->start, s0 );
+                unsigned int hi = std::min( run->start + run->size, s1 );
+                if (lo<hi) {
+                    f( lo, 1., p + (lo - run->start), hi - lo );
+                }
+                p += run->size;
+            }
+            return;
+        }
+        
+        // segments are the support of the last factor, for each outer 
+        // sample (i.e. combination of samples in the other factors) within
+        // the support of the outer factors
+        unsigned int D = factor_sizes_.size();
+        unsigned int G = factor_sizes_[D-1];
+        const value * factor[MAX_GRID_FACTORS];
+        
+        unsigned int first = 0;
+        unsigned int last = 0;
+        
+        for (unsigned int d=0; d<D; ++d) {
+            if (row.begin[d].size==0) { return; }
+            factor[d] = p;
+            p += row.begin[d].size;
+            if (d<D-1) {
+                first += row.begin[d].start * (factor_strides_[d]/G);
+                last += (row.begin[d].start + row.begin[d].size - 1) * (factor_strides_[d]/G);
+            }
+        }
+        
+        const Run & inner = row.begin[D-1];
+        
+        first = std::max( first, s0/G );
+        last = std::min( last, s1>0 ? (s1-1)/G : 0 );
+        
+        for (unsigned int outer=first; outer<=last && s0<s1; ++outer) {
+            
+            value scale = 1.;
+            unsigned int remainder = outer;
+            
+            for (unsigned int d=0; d<D-1 && scale!=0.; ++d) {
+                unsigned int stride = factor_strides_[d]/G;
+                // index relative to start of support (wraps if before start)
+                unsigned int index = remainder/stride - row.begin[d].start;
+                remainder %= stride;
+                scale = index<row.begin[d].size ? scale * factor[d][index] : 0.;
+            }
+            
+            if (scale==0.) { continue; }
+            
+            unsigned int start = outer*G + inner.start;
+            unsigned int lo = std::max( start, s0 );
+            unsigned int hi = std::min( start + inner.size, s1 );
+            
+            if (lo<hi) {
+                f( lo, scale, factor[D-1] + (lo - start), hi - lo );
+            }
+        }
+    }
+    
+    // restore rows that were saved as consecutive runs (start, size pairs) 
+    // and their values, with run_counts[c] runs in row c
+    PartialMixture( const Mixture * source, const Grid & grid, 
+        const std::vector<unsigned int> & factor_sizes,
+        const std::vector<unsigned int> & run_counts, 
+        const std::vector<unsigned int> & runs, const std::vector<value> & logp );
+    void rows_( std::vector<unsigned int> & run_counts, 
+        std::vector<unsigned int> & runs, std::vector<value> & logp ) const;
+    
+    // use factorized rows if grid is separable in the mixture space
+    void set_factors_( const Grid & grid );
+    // size of a row of (dense or factorized) partial log probabilities
+    unsigned int row_size_() const;
+    // evaluate rows of components on grid
+    void evaluate_rows_( const Grid & grid, 
+        const std::vector<unsigned int> & components, value * logp ) const;
+    void append_row_( Block & block, const value * logp ) const;
+    
+    // splits [K x nsamples] partial log probability matrix into blocks
+    void set_partial_logp_( const std::vector<value> & logp );
+    void precompute_();
+    
+    // computes result[n x nsamples] = A[n x K] * partial_p_[K x nsamples]
+    // with A[e,c] = w_c * exp( partial logp of event e in component c )
+    void complete_block_( const value * points, unsigned int n, 
+        std::vector<value> & A, value * result ) const;
 };
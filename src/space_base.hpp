@@ -91,11 +91,11 @@ public:
     value compute_scale_factor( Component & k, const std::vector<bool> & selection, 
         bool log = false ) const;
     
-    virtual value compute_scale_factor( value * bw, bool log = false ) const { 
+    virtual value compute_scale_factor( const value * bw, bool log = false ) const { 
         return 1.;
     }
     virtual value compute_scale_factor( std::vector<bool>::const_iterator selection, 
-        value * bw, bool log=false ) const { 
+        const value * bw, bool log=false ) const { 
         return 1.;
     }
     
@@ -104,6 +104,12 @@ public:
     virtual value mahalanobis_distance_squared( const value * refloc, 
         const value * refbw, const value * targetloc, value threshold) const;
     
+    // collect location and bandwidth indices of dimensions for which the
+    // mahalanobis distance is the euclidean distance scaled by bandwidth
+    virtual void euclidean_dimensions( std::vector<unsigned int> & loc, 
+        std::vector<unsigned int> & bw, unsigned int loc_offset = 0, 
+        unsigned int bw_offset = 0 ) const {}
+    
     void merge( value w1, Component & first, value w2, const Component & second ) const;
     virtual void merge( value w1, value * loc1, value * bw1, value w2, 
         const value * loc2, const value * bw2 ) const;
@@ -120,11 +126,11 @@ public:
     virtual void log_probability( const value * loc, const value * bw, 
         const value * points, unsigned int n, value * result ) const;
     
-    void probability( Grid & grid, value weight, const Component & k, value * result ) {
+    void probability( const Grid & grid, value weight, const Component & k, value * result ) {
         probability( grid, weight, k.location.data(), k.bandwidth.data(), result );
     }
     
-    virtual void probability( Grid & grid, value weight, const value * loc, 
+    virtual void probability( const Grid & grid, value weight, const value * loc, 
         const value * bw, value * result ) const {
         throw std::runtime_error("Space::probability(Grid,...) not implemented.");
     }
@@ -134,11 +140,11 @@ public:
     virtual value partial_logp( const value * loc, const value * bw, 
         const value * point, std::vector<bool>::const_iterator selection ) const;
     
-    void partial_logp( Grid & grid, std::vector<bool> & selection, 
+    void partial_logp( const Grid & grid, std::vector<bool> & selection, 
         value factor, const Component & k, value * result ) {
         partial_logp( grid, selection.cbegin(), factor, k.location.data(), k.bandwidth.data(), result );
     }
-    virtual void partial_logp( Grid & grid, 
+    virtual void partial_logp( const Grid & grid, 
         std::vector<bool>::const_iterator selection, value factor, 
             const value * loc, const value * bw, value * result ) const {
         throw std::runtime_error("Space::partial_logp(Grid,...) not implemented.");
@@ -179,12 +185,12 @@ public:
         return new T(static_cast<T const&>(*this));
     }
     
-    virtual void probability( Grid & grid, value weight, const value * loc, 
+    virtual void probability( const Grid & grid, value weight, const value * loc, 
         const value * bw, value * result ) const override final{
         grid.probability( *(static_cast<const T*>(this)), weight, loc, bw, result );
     }
     
-    virtual void partial_logp( Grid & grid, 
+    virtual void partial_logp( const Grid & grid, 
         std::vector<bool>::const_iterator selection, value factor, 
         const value * loc, const value * bw, value * result ) const override final {
         
@@ -56,12 +56,12 @@ Grid * CategoricalSpace::grid() const {
 }
  
 // methods
-value CategoricalSpace::compute_scale_factor( value * bw, bool log ) const {
+value CategoricalSpace::compute_scale_factor( const value * bw, bool log ) const {
     if (log) { return 0.; } else { return 1.; };
 }
 
 value CategoricalSpace::compute_scale_factor( 
-    std::vector<bool>::const_iterator selection, value * bw, bool log ) const {
+    std::vector<bool>::const_iterator selection, const value * bw, bool log ) const {
     if (log) { return 0.; } else { return 1.; };
 }
 
@@ -32,8 +32,8 @@ public:
     Grid * grid() const;
     
     // methods
-    virtual value compute_scale_factor( value * bw, bool log = false ) const override;
-    virtual value compute_scale_factor( std::vector<bool>::const_iterator selection, value * bw, bool log=false ) const override;
+    virtual value compute_scale_factor( const value * bw, bool log = false ) const override;
+    virtual value compute_scale_factor( std::vector<bool>::const_iterator selection, const value * bw, bool log=false ) const override;
     
     virtual value mahalanobis_distance_squared( const value * refloc, const value * refbw, const value * targetloc, value threshold) const override;
     
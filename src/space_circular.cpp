@@ -51,12 +51,12 @@ Grid * CircularSpace::grid(unsigned int n, value offset) const {
 }
 
 // methods
-value CircularSpace::compute_scale_factor( value * bw, bool log ) const {
+value CircularSpace::compute_scale_factor( const value * bw, bool log ) const {
     return vonmises_scale_factor( *bw, log );
 }
 
 value CircularSpace::compute_scale_factor(
-    std::vector<bool>::const_iterator selection, value * bw, bool log ) const {
+    std::vector<bool>::const_iterator selection, const value * bw, bool log ) const {
     
     value s;
     if (*selection) {
@@ -165,13 +165,13 @@ Grid * EncodedSpace::grid(const std::vector<value> & v,
 }
 
 // methods
-value EncodedSpace::compute_scale_factor( value * bw, bool log) const {
+value EncodedSpace::compute_scale_factor( const value * bw, bool log) const {
     
     return kernel_->scale_factor( 1, bw, log );
 }
 
 value EncodedSpace::compute_scale_factor( std::vector<bool>::const_iterator selection, 
-    value * bw, bool log) const {
+    const value * bw, bool log) const {
     
     return kernel_->scale_factor( 1, bw, log, selection );
 }
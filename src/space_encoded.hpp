@@ -57,9 +57,9 @@ public:
     Grid * grid(const std::vector<value> & v, const std::vector<bool> & valid = {}) const;
         
     // methods
-    virtual value compute_scale_factor( value * bw, bool log = false ) const override;
+    virtual value compute_scale_factor( const value * bw, bool log = false ) const override;
     virtual value compute_scale_factor( std::vector<bool>::const_iterator selection, 
-        value * bw, bool log=false ) const override;
+        const value * bw, bool log=false ) const override;
     
     unsigned int get_index(value x) const;
     
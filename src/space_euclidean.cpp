@@ -123,13 +123,13 @@ VectorGrid * EuclideanSpace::grid( const std::vector<std::vector<value>> & vecto
 
 
 // methods
-value EuclideanSpace::compute_scale_factor( value * bw, bool log) const {
+value EuclideanSpace::compute_scale_factor( const value * bw, bool log) const {
     
     return kernel_->scale_factor( ndim(), bw, log );
 }
 
 value EuclideanSpace::compute_scale_factor(
-    std::vector<bool>::const_iterator selection, value * bw, bool log) const {
+    std::vector<bool>::const_iterator selection, const value * bw, bool log) const {
     
     return kernel_->scale_factor( ndim(), bw, log, selection );
 }
@@ -152,6 +152,16 @@ value EuclideanSpace::mahalanobis_distance_squared( const value * refloc,
     return d;
 }
 
+void EuclideanSpace::euclidean_dimensions( std::vector<unsigned int> & loc, 
+    std::vector<unsigned int> & bw, unsigned int loc_offset, 
+    unsigned int bw_offset ) const {
+    
+    for (unsigned int k=0; k<ndim(); ++k) {
+        loc.push_back( loc_offset + k );
+        bw.push_back( bw_offset + k );
+    }
+}
+
 void EuclideanSpace::merge( value w1, value * loc1, value * bw1, value w2, 
     const value * loc2, const value * bw2 ) const {
     
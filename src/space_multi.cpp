@@ -87,7 +87,7 @@ Grid * MultiSpace::grid( const std::vector<Grid*> & grids,
 }    
 
 // methods
-value MultiSpace::compute_scale_factor( value * bw, bool log ) const {
+value MultiSpace::compute_scale_factor( const value * bw, bool log ) const {
    value s;
     if (log) {
         s = 0.;
@@ -106,7 +106,7 @@ value MultiSpace::compute_scale_factor( value * bw, bool log ) const {
 }
 
 value MultiSpace::compute_scale_factor( std::vector<bool>::const_iterator selection, 
-    value * bw, bool log ) const {
+    const value * bw, bool log ) const {
    value s;
     if (log) {
         s = 0.;
@@ -145,6 +145,19 @@ value MultiSpace::mahalanobis_distance_squared( const value * refloc,
     return d;
 }
 
+void MultiSpace::euclidean_dimensions( std::vector<unsigned int> & loc, 
+    std::vector<unsigned int> & bw, unsigned int loc_offset, 
+    unsigned int bw_offset ) const {
+    
+    for (unsigned int k=0; k<spaces_.size(); ++k) {
+        
+        spaces_[k]->euclidean_dimensions( loc, bw, loc_offset, bw_offset );
+        
+        loc_offset += spaces_[k]->ndim();
+        bw_offset += spaces_[k]->nbw();
+    }
+}
+
 void MultiSpace::merge( value w1, value * loc1, value * bw1, value w2, 
     const value * loc2, const value * bw2 ) const {
 
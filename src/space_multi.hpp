@@ -45,13 +45,17 @@ public:
         const std::vector<bool> & valid = {}) const;
     
     // methods
-    virtual value compute_scale_factor( value * bw, bool log = false ) const override;
+    virtual value compute_scale_factor( const value * bw, bool log = false ) const override;
     virtual value compute_scale_factor( std::vector<bool>::const_iterator selection, 
-        value * bw, bool log=false ) const override;
+        const value * bw, bool log=false ) const override;
     
     virtual value mahalanobis_distance_squared( const value * refloc, 
         const value * refbw, const value * targetloc, value threshold) const override;
     
+    virtual void euclidean_dimensions( std::vector<unsigned int> & loc, 
+        std::vector<unsigned int> & bw, unsigned int loc_offset = 0, 
+        unsigned int bw_offset = 0 ) const override;
+    
     virtual void merge( value w1, value * loc1, value * bw1, value w2, 
         const value * loc2, const value * bw2 ) const override;
     
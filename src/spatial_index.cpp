@@ -0,0 +1,387 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "spatial_index.hpp"
+#include "space_base.hpp"
+
+#include <limits>
+#include <numeric>
+
+// relative margin on cell width to guard against round-off errors
+static const value CELL_MARGIN = 1.001;
+// merging increases bandwidths, so leave headroom when setting the cell width
+static const value CELL_HEADROOM = 1.25;
+
+// constructor
+SpatialIndex::SpatialIndex( const Space & space, value threshold ) :
+threshold_(threshold) {
+    
+    space.euclidean_dimensions( loc_index_, bw_index_ );
+    
+    if (loc_index_.size()>SPATIAL_INDEX_MAXDIM) {
+        loc_index_.resize( SPATIAL_INDEX_MAXDIM );
+        bw_index_.resize( SPATIAL_INDEX_MAXDIM );
+    }
+    
+    // initial cell width is based on the bandwidth of the default kernel
+    for (auto & k : bw_index_) {
+        cell_width_.push_back( CELL_HEADROOM * CELL_MARGIN * threshold_ * 
+            space.default_kernel().bandwidth[k] );
+    }
+    
+    // disable index if cell width is not valid
+    for (auto & w : cell_width_) {
+        if (!(w>0) || !std::isfinite(w)) {
+            loc_index_.clear();
+            bw_index_.clear();
+            cell_width_.clear();
+            break;
+        }
+    }
+}
+
+// properties
+bool SpatialIndex::enabled() const { return !loc_index_.empty(); }
+unsigned int SpatialIndex::size() const { return key_.size(); }
+value SpatialIndex::threshold() const { return threshold_; }
+
+// methods
+void SpatialIndex::clear() {
+    loc_.clear();
+    bw_.clear();
+    key_.clear();
+    overflow_.clear();
+    cells_.clear();
+    overflow_list_.clear();
+    cell_min_.clear();
+    cell_max_.clear();
+    bw_max_.clear();
+}
+
+void SpatialIndex::coarsen( value n ) {
+    
+    while (cells_.size()>1 && size()-overflow_list_.size() < n*cells_.size()) {
+        for (auto & w : cell_width_) { w *= 2.; }
+        reindex_();
+    }
+}
+
+void SpatialIndex::insert( const value * loc, const value * bw ) {
+    
+    for (unsigned int d=0; d<loc_index_.size(); ++d) {
+        loc_.push_back( loc[loc_index_[d]] );
+        bw_.push_back( bw[bw_index_[d]] );
+    }
+    
+    key_.push_back( 0 );
+    overflow_.push_back( false );
+    
+    add_( key_.size()-1 );
+    
+    if (overflow_list_.size() > std::max<size_t>( SPATIAL_INDEX_MIN_OVERFLOW, key_.size()/16 )) {
+        rebuild_();
+    }
+}
+
+void SpatialIndex::update( unsigned int index, const value * loc, const value * bw ) {
+    
+    if (index>=size()) {
+        throw std::runtime_error("Internal error: spatial index out of range.");
+    }
+    
+    remove_( index );
+    
+    unsigned int ndim = loc_index_.size();
+    for (unsigned int d=0; d<ndim; ++d) {
+        loc_[index*ndim + d] = loc[loc_index_[d]];
+        bw_[index*ndim + d] = bw[bw_index_[d]];
+    }
+    
+    add_( index );
+    
+    if (overflow_list_.size() > std::max<size_t>( SPATIAL_INDEX_MIN_OVERFLOW, key_.size()/16 )) {
+        rebuild_();
+    }
+}
+
+void SpatialIndex::candidates( const value * loc, std::vector<unsigned int> & result ) const {
+    
+    unsigned int ndim = loc_index_.size();
+    
+    result.clear();
+    result.insert( result.end(), overflow_list_.begin(), overflow_list_.end() );
+    
+    std::vector<value> target( ndim );
+    for (unsigned int d=0; d<ndim; ++d) {
+        target[d] = loc[loc_index_[d]];
+    }
+    
+    std::vector<long long> center( ndim );
+    if (!cell( target.data(), center.data() )) {
+        // target location cannot be bucketed, so all components are candidates
+        result.resize( size() );
+        std::iota( result.begin(), result.end(), 0 );
+        return;
+    }
+    
+    // visit target cell and all directly neighboring cells
+    std::vector<int> offset( ndim, -1 );
+    std::vector<long long> c( ndim );
+    
+    while (true) {
+        
+        for (unsigned int d=0; d<ndim; ++d) {
+            c[d] = center[d] + offset[d];
+        }
+        
+        auto it = cells_.find( cell_key( c.data() ) );
+        if (it!=cells_.end()) {
+            result.insert( result.end(), it->second.begin(), it->second.end() );
+        }
+        
+        unsigned int d = 0;
+        for (; d<ndim; ++d) {
+            if (++offset[d]<=1) { break; }
+            offset[d] = -1;
+        }
+        if (d==ndim) { break; }
+    }
+    
+    // neighboring cells may hash to the same bucket
+    std::sort( result.begin(), result.end() );
+    result.erase( std::unique( result.begin(), result.end() ), result.end() );
+}
+
+bool SpatialIndex::ring( const value * loc, unsigned int r, std::vector<unsigned int> & result ) const {
+    
+    unsigned int ndim = loc_index_.size();
+    
+    result.clear();
+    
+    if (r==0) {
+        result.insert( result.end(), overflow_list_.begin(), overflow_list_.end() );
+    }
+    
+    std::vector<value> target( ndim );
+    for (unsigned int d=0; d<ndim; ++d) {
+        target[d] = loc[loc_index_[d]];
+    }
+    
+    std::vector<long long> center( ndim );
+    if (!cell( target.data(), center.data() )) {
+        // target location cannot be bucketed, so all components are in ring 0
+        if (r==0) {
+            result.resize( size() );
+            std::iota( result.begin(), result.end(), 0 );
+        }
+        return false;
+    }
+    
+    if (cells_.empty()) { return false; }
+    
+    // largest ring that contains occupied cells
+    long long rmax = 0;
+    for (unsigned int d=0; d<ndim; ++d) {
+        rmax = std::max( rmax, std::max( center[d]-cell_min_[d], cell_max_[d]-center[d] ) );
+    }
+    
+    if (r>rmax) { return false; }
+    
+    std::vector<long long> c( ndim );
+    
+    // if the ring has more cells than there are components, scan all components
+    value ncells = std::pow( 2.*r+1., ndim ) - (r>0 ? std::pow( 2.*r-1., ndim ) : 0.);
+    if (ncells > size()) {
+        for (auto & bucket : cells_) {
+            for (auto & k : bucket.second) {
+                cell( loc_.data() + k*ndim, c.data() );
+                long long dist = 0;
+                for (unsigned int d=0; d<ndim; ++d) {
+                    dist = std::max( dist, std::abs( c[d]-center[d] ) );
+                }
+                if (dist>=r) { result.push_back( k ); }
+            }
+        }
+        return false;
+    }
+    
+    // visit all cells at distance r: loop over all offsets in the first 
+    // ndim-1 dimensions, the last dimension only needs offsets -r and r 
+    // unless one of the other offsets is already at distance r
+    long long radius = r;
+    std::vector<long long> offset( ndim, -radius );
+    
+    while (true) {
+        
+        bool boundary = false;
+        for (unsigned int d=0; d+1<ndim; ++d) {
+            c[d] = center[d] + offset[d];
+            boundary = boundary || std::abs(offset[d])==radius;
+        }
+        
+        long long step = (boundary || radius==0) ? 1 : 2*radius;
+        for (long long o=-radius; o<=radius; o+=step) {
+            c[ndim-1] = center[ndim-1] + o;
+            auto it = cells_.find( cell_key( c.data() ) );
+            if (it!=cells_.end()) {
+                result.insert( result.end(), it->second.begin(), it->second.end() );
+            }
+        }
+        
+        unsigned int d = 0;
+        for (; d+1<ndim; ++d) {
+            if (++offset[d]<=radius) { break; }
+            offset[d] = -radius;
+        }
+        if (d+1>=ndim) { break; }
+    }
+    
+    return radius<rmax;
+}
+
+value SpatialIndex::ring_distance_squared( const value * bw, unsigned int r ) const {
+    
+    if (r<2 || bw_max_.empty()) { return 0.; }
+    
+    // a bucketed component in ring r is separated from the target by at 
+    // least r-1 cells in one of the dimensions
+    value result = std::numeric_limits<value>::infinity();
+    
+    for (unsigned int d=0; d<loc_index_.size(); ++d) {
+        value b = CELL_MARGIN * std::max( bw[bw_index_[d]], bw_max_[d] );
+        value gap = (r-1) * cell_width_[d] / b;
+        result = std::min( result, gap*gap );
+    }
+    
+    return result;
+}
+
+// protected methods
+bool SpatialIndex::cell( const value * loc, long long * result ) const {
+    
+    value c;
+    
+    for (unsigned int d=0; d<loc_index_.size(); ++d) {
+        c = std::floor( loc[d] / cell_width_[d] );
+        if (!std::isfinite(c) || std::abs(c)>static_cast<value>(std::numeric_limits<long long>::max()/2)) {
+            return false;
+        }
+        result[d] = static_cast<long long>( c );
+    }
+    
+    return true;
+}
+
+size_t SpatialIndex::cell_key( const long long * c ) const {
+    
+    size_t key = 0;
+    
+    for (unsigned int d=0; d<loc_index_.size(); ++d) {
+        key = hash_combine( key, std::hash<long long>()( c[d] ) );
+    }
+    
+    return key;
+}
+
+void SpatialIndex::add_( unsigned int index ) {
+    
+    unsigned int ndim = loc_index_.size();
+    
+    const value * loc = loc_.data() + index*ndim;
+    const value * bw = bw_.data() + index*ndim;
+    
+    // a component that is matched by a target in a non-neighboring cell
+    // (i.e. its bandwidth is too large) is put on the overflow list
+    bool wide = false;
+    for (unsigned int d=0; d<ndim; ++d) {
+        if (!(CELL_MARGIN * threshold_ * bw[d] <= cell_width_[d])) { wide = true; break; }
+    }
+    
+    std::vector<long long> c( ndim );
+    
+    if (wide || !cell( loc, c.data() )) {
+        overflow_[index] = true;
+        overflow_list_.push_back( index );
+    } else {
+        overflow_[index] = false;
+        key_[index] = cell_key( c.data() );
+        cells_[key_[index]].push_back( index );
+        
+        if (cell_min_.empty()) {
+            cell_min_ = c;
+            cell_max_ = c;
+            bw_max_.assign( bw, bw+ndim );
+        }
+        for (unsigned int d=0; d<ndim; ++d) {
+            cell_min_[d] = std::min( cell_min_[d], c[d] );
+            cell_max_[d] = std::max( cell_max_[d], c[d] );
+            bw_max_[d] = std::max( bw_max_[d], bw[d] );
+        }
+    }
+}
+
+void SpatialIndex::remove_( unsigned int index ) {
+    
+    std::vector<unsigned int> * bucket;
+    
+    if (overflow_[index]) {
+        bucket = &overflow_list_;
+    } else {
+        bucket = &cells_[key_[index]];
+    }
+    
+    auto it = std::find( bucket->begin(), bucket->end(), index );
+    if (it!=bucket->end()) {
+        *it = bucket->back();
+        bucket->pop_back();
+    }
+    
+    if (!overflow_[index] && bucket->empty()) {
+        cells_.erase( key_[index] );
+    }
+}
+
+void SpatialIndex::rebuild_() {
+    
+    unsigned int ndim = loc_index_.size();
+    
+    // enlarge cells such that all components fit (with some headroom)
+    for (unsigned int k=0; k<size(); ++k) {
+        for (unsigned int d=0; d<ndim; ++d) {
+            value w = CELL_HEADROOM * CELL_MARGIN * threshold_ * bw_[k*ndim + d];
+            if (std::isfinite(w) && w>cell_width_[d]) {
+                cell_width_[d] = w;
+            }
+        }
+    }
+    
+    reindex_();
+}
+
+void SpatialIndex::reindex_() {
+    
+    cells_.clear();
+    overflow_list_.clear();
+    cell_min_.clear();
+    cell_max_.clear();
+    bw_max_.clear();
+    
+    for (unsigned int k=0; k<size(); ++k) {
+        add_( k );
+    }
+}
@@ -0,0 +1,113 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+// maximum number of (euclidean) dimensions that are used to bucket components
+static const unsigned int SPATIAL_INDEX_MAXDIM = 4;
+// minimum number of components in overflow list before index is rebuilt
+static const unsigned int SPATIAL_INDEX_MIN_OVERFLOW = 64;
+
+class Space;
+
+// Exact spatial index over component locations, used to speed up the search
+// for the closest component during compression. Components are hashed into
+// a uniform grid of cells in (a subset of) the euclidean dimensions of the
+// space. The cell width is chosen such that any component within the
+// compression threshold (in mahalanobis distance) of a target location
+// is in the target's cell or in one of the directly neighboring cells.
+// Components with a bandwidth too large for the current cell width are kept
+// in an overflow list that is always searched. If the overflow list grows too
+// large, the cells are enlarged and the index is rebuilt. For searches
+// without a fixed threshold (e.g. in mixture reduction), the cells can be
+// visited in rings of increasing distance around the target.
+class SpatialIndex {
+public:
+    // constructor
+    SpatialIndex( const Space & space, value threshold );
+    
+    // properties
+    bool enabled() const;
+    unsigned int size() const;
+    value threshold() const;
+    
+    // methods
+    void clear();
+    // enlarge cells until there are on average at least n components per cell
+    void coarsen( value n );
+    
+    // add component at the end of the index
+    void insert( const value * loc, const value * bw );
+    // update location/bandwidth of indexed component (e.g. after merge)
+    void update( unsigned int index, const value * loc, const value * bw );
+    
+    // collect indices (sorted, ascending) of all components that could 
+    // be within the compression threshold of the target location
+    void candidates( const value * loc, std::vector<unsigned int> & result ) const;
+    
+    // collect indices of all components in the cells at distance r (i.e. 
+    // maximum difference in cell coordinates) from the target cell, where 
+    // ring 0 includes the overflow list. Returns false if there are no 
+    // components beyond ring r, in which case the result may include all 
+    // remaining components at distance r or larger.
+    bool ring( const value * loc, unsigned int r, std::vector<unsigned int> & result ) const;
+    // lower bound on the squared mahalanobis distance between a target 
+    // with bandwidth bw and any component in ring r
+    value ring_distance_squared( const value * bw, unsigned int r ) const;
+    
+protected:
+    bool cell( const value * loc, long long * result ) const;
+    size_t cell_key( const long long * c ) const;
+    
+    void add_( unsigned int index );
+    void remove_( unsigned int index );
+    void rebuild_();
+    void reindex_();
+    
+protected:
+    value threshold_;
+    
+    // location and bandwidth indices of bucketed dimensions
+    std::vector<unsigned int> loc_index_;
+    std::vector<unsigned int> bw_index_;
+    
+    // cell width for each bucketed dimension
+    std::vector<value> cell_width_;
+    
+    // per component: location and bandwidth in bucketed dimensions
+    std::vector<value> loc_;
+    std::vector<value> bw_;
+    // per component: cell key or overflow state
+    std::vector<size_t> key_;
+    std::vector<bool> overflow_;
+    
+    std::unordered_map<size_t, std::vector<unsigned int>> cells_;
+    std::vector<unsigned int> overflow_list_;
+    
+    // range of occupied cell coordinates and largest bandwidth of bucketed
+    // components for each bucketed dimension
+    std::vector<long long> cell_min_;
+    std::vector<long long> cell_max_;
+    std::vector<value> bw_max_;
+};
@@ -18,9 +18,12 @@
 // ---------------------------------------------------------------------
 #include "stimulus.hpp"
 
+#include <sstream>
+
 // constructor
 StimulusOccupancy::StimulusOccupancy( const Space & space, const Grid & grid, double stimulus_duration, value compression ) :
-stimulus_duration_(stimulus_duration), compression_(compression) {
+stimulus_duration_(stimulus_duration), compression_(compression), 
+version_(1), cache_version_(0), fingerprint_version_(0), fingerprint_(0) {
     
     if (!(space.specification()==grid.specification())) {
         throw std::runtime_error("Grid does not match stimulus space.");
@@ -47,6 +50,34 @@ unsigned int StimulusOccupancy::ndim() const { return stimulus_grid_->ndim(); }
 bool StimulusOccupancy::random_insertion() const { return random_insertion_; }
 void StimulusOccupancy::set_random_insertion(bool val) { random_insertion_ = val; }
 
+unsigned int StimulusOccupancy::max_components() const { 
+    return stimulus_distribution_->max_components();
+}
+void StimulusOccupancy::set_max_components(unsigned int n) {
+    std::lock_guard<std::mutex> guard( lock_ );
+    unsigned int ncomponents = stimulus_distribution_->ncomponents();
+    stimulus_distribution_->set_max_components( n );
+    if (stimulus_distribution_->ncomponents()!=ncomponents) { ++version_; }
+}
+
+value StimulusOccupancy::min_weight() const { 
+    return stimulus_distribution_->min_weight();
+}
+void StimulusOccupancy::set_min_weight(value v) {
+    std::lock_guard<std::mutex> guard( lock_ );
+    unsigned int ncomponents = stimulus_distribution_->ncomponents();
+    stimulus_distribution_->set_min_weight( v );
+    if (stimulus_distribution_->ncomponents()!=ncomponents) { ++version_; }
+}
+
+unsigned int StimulusOccupancy::nthreads() const { 
+    return stimulus_distribution_->nthreads();
+}
+void StimulusOccupancy::set_nthreads( unsigned int n ) {
+    std::lock_guard<std::mutex> guard( lock_ );
+    stimulus_distribution_->set_nthreads( n );
+}
+
 value StimulusOccupancy::stimulus_time() {
     
     lock_.lock();
@@ -55,6 +86,31 @@ value StimulusOccupancy::stimulus_time() {
     return t;
 }
 
+unsigned long StimulusOccupancy::version() {
+    std::lock_guard<std::mutex> guard( lock_ );
+    return version_;
+}
+
+uint64_t StimulusOccupancy::fingerprint() {
+    
+    std::lock_guard<std::mutex> guard( lock_ );
+    
+    // the fingerprint is computed for each precomputed likelihood state,
+    // so it is cached until the stimulus distribution changes
+    if (fingerprint_version_==version_) { return fingerprint_; }
+    
+    std::ostringstream grid;
+    stimulus_grid_->save_to_yaml( grid, true );
+    std::string s = grid.str();
+    
+    uint64_t h = stimulus_distribution_->fingerprint();
+    h = hash_bytes( &stimulus_duration_, sizeof(stimulus_duration_), h );
+    fingerprint_ = hash_bytes( s.data(), s.size(), h );
+    fingerprint_version_ = version_;
+    
+    return fingerprint_;
+}
+
 void StimulusOccupancy::occupancy( std::vector<value> & out ) {
 
     out.resize( stimulus_grid_->size() );
@@ -74,26 +130,38 @@ void StimulusOccupancy::logp( std::vector<value> & out ) {
     
 void StimulusOccupancy::occupancy( value * out ) {
     
-    value factor;
+    std::lock_guard<std::mutex> guard( lock_ );
+    update_cache_();
     
-    lock_.lock();
-    stimulus_distribution_->evaluate( *stimulus_grid_, out );
-    factor = stimulus_distribution_->sum_of_weights() * stimulus_duration_;
-    lock_.unlock();
+    value factor = stimulus_distribution_->sum_of_weights() * stimulus_duration_;
     
-    std::transform( out, out + stimulus_grid_->size(), out, [factor](const value &a) { return a * factor;  } );
+    std::transform( prob_cache_.begin(), prob_cache_.end(), out, [factor](const value &a) { return a * factor;  } );
     
 }
 void StimulusOccupancy::prob( value * out ) {
 
-    lock_.lock();
-    stimulus_distribution_->evaluate( *stimulus_grid_, out );
-    lock_.unlock();
+    std::lock_guard<std::mutex> guard( lock_ );
+    update_cache_();
+    std::copy( prob_cache_.begin(), prob_cache_.end(), out );
 }
 void StimulusOccupancy::logp( value * out ) {
     
-    prob( out );
-    std::transform( out, out + stimulus_grid_->size(), out, [](const value &a) { return fastlog(a);  } );
+    std::lock_guard<std::mutex> guard( lock_ );
+    update_cache_();
+    std::copy( logp_cache_.begin(), logp_cache_.end(), out );
+}
+
+void StimulusOccupancy::update_cache_() {
+    
+    if (cache_version_==version_) { return; }
+    
+    prob_cache_.resize( stimulus_grid_->size() );
+    stimulus_distribution_->evaluate( *stimulus_grid_, prob_cache_.data() );
+    
+    logp_cache_.resize( stimulus_grid_->size() );
+    fastlog_n( prob_cache_.data(), logp_cache_.data(), stimulus_grid_->size() );
+    
+    cache_version_ = version_;
 }
 
 // methods
@@ -114,9 +182,33 @@ void StimulusOccupancy::add_stimulus( const value * stimuli, unsigned int n,
     lock_.lock();
     stimulus_distribution_->merge_samples( stimuli, n, random_insertion_, 
         static_cast<value>(repetitions) );
+    ++version_;
     lock_.unlock();
 }
 
+void StimulusOccupancy::merge_stimulus( StimulusOccupancy & other ) {
+    
+    if (&other==this) {
+        std::lock_guard<std::mutex> guard( lock_ );
+        Mixture copy( *stimulus_distribution_ );
+        stimulus_distribution_->merge_mixture( copy );
+        ++version_;
+        return;
+    }
+    
+    if (!(*other.stimulus_grid_==*stimulus_grid_) || 
+        other.stimulus_duration_!=stimulus_duration_) {
+        throw std::runtime_error("Stimulus grid or duration does not match.");
+    }
+    
+    std::lock( lock_, other.lock_ );
+    std::lock_guard<std::mutex> guard( lock_, std::adopt_lock );
+    std::lock_guard<std::mutex> other_guard( other.lock_, std::adopt_lock );
+    
+    stimulus_distribution_->merge_mixture( *other.stimulus_distribution_ );
+    ++version_;
+}
+
 // yaml
 YAML::Node StimulusOccupancy::to_yaml( ) const {
     
@@ -192,7 +284,8 @@ flatbuffers::Offset<fb_serialize::StimulusOccupancy> StimulusOccupancy::to_flatb
     );
 }
 
-std::unique_ptr<StimulusOccupancy> StimulusOccupancy::from_flatbuffers(const fb_serialize::StimulusOccupancy * stimulus) {
+std::unique_ptr<StimulusOccupancy> StimulusOccupancy::from_flatbuffers(const fb_serialize::StimulusOccupancy * stimulus,
+    std::shared_ptr<const void> owner) {
 
     auto duration = stimulus->stimulus_duration();
     auto compression = stimulus->compression();
@@ -200,7 +293,7 @@ std::unique_ptr<StimulusOccupancy> StimulusOccupancy::from_flatbuffers(const fb_
 
     auto grid = grid_from_flatbuffers(stimulus->stimulus_grid());
 
-    auto mix = Mixture::from_flatbuffers(stimulus->stimulus_distribution());
+    auto mix = Mixture::from_flatbuffers(stimulus->stimulus_distribution(), owner);
 
     auto stim = std::make_unique<StimulusOccupancy>(mix->space(), *grid, 
         duration, compression);
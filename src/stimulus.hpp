@@ -41,9 +41,27 @@ public:
     
     bool random_insertion() const;
     void set_random_insertion(bool val);
+    
+    // size bounds of stimulus distribution (see Mixture)
+    unsigned int max_components() const;
+    void set_max_components(unsigned int n);
+    value min_weight() const;
+    void set_min_weight(value v);
+    
+    // worker threads for evaluation on grid (see Mixture)
+    unsigned int nthreads() const;
+    void set_nthreads( unsigned int n );
         
     value stimulus_time();
     
+    // incremented for every change of the stimulus distribution
+    unsigned long version();
+    
+    // fingerprint of stimulus distribution, grid and duration
+    uint64_t fingerprint();
+    
+    // probability and log probability on the grid are cached until the
+    // stimulus distribution changes
     void occupancy( std::vector<value> & out );
     void prob( std::vector<value> & out ) ;
     void logp( std::vector<value> & out );
@@ -56,6 +74,9 @@ public:
     void add_stimulus( const std::vector<value> & stimuli, unsigned repetitions = 1 );
     void add_stimulus( const value * stimuli, unsigned int n, 
         unsigned int repetitions = 1 );
+    // merge stimulus distribution of other occupancy with the same space, 
+    // grid and stimulus duration (e.g. trained on a different shard of data)
+    void merge_stimulus( StimulusOccupancy & other );
     
     // yaml
     YAML::Node to_yaml( ) const;
@@ -65,7 +86,8 @@ public:
     
     // flatbuffers
     flatbuffers::Offset<fb_serialize::StimulusOccupancy> to_flatbuffers(flatbuffers::FlatBufferBuilder &builder) const;
-    static std::unique_ptr<StimulusOccupancy> from_flatbuffers(const fb_serialize::StimulusOccupancy * stimulus);
+    static std::unique_ptr<StimulusOccupancy> from_flatbuffers(const fb_serialize::StimulusOccupancy * stimulus,
+        std::shared_ptr<const void> owner = nullptr);
 
     // hdf5
     void to_hdf5(HighFive::Group & group) const;
@@ -85,4 +107,17 @@ protected:
     std::unique_ptr<Mixture> stimulus_distribution_;
     std::unique_ptr<Grid> stimulus_grid_;
     std::mutex lock_;
+    
+    unsigned long version_;
+    // version of stimulus distribution for which the cache is valid
+    unsigned long cache_version_;
+    std::vector<value> prob_cache_;
+    std::vector<value> logp_cache_;
+    // version of stimulus distribution for which the fingerprint is valid
+    unsigned long fingerprint_version_;
+    uint64_t fingerprint_;
+    
+    // re-evaluates stimulus distribution on grid if it has changed,
+    // should be called with lock held
+    void update_cache_();
 };
@@ -0,0 +1,397 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "streaming_decoder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+// constructor
+StreamingDecoder::StreamingDecoder( Decoder & decoder, value bin_size, value step,
+    unsigned int capacity, unsigned int index, bool normalize, double origin ) :
+decoder_(&decoder), bin_size_(bin_size), step_(step), index_(index),
+normalize_(normalize), origin_(origin), window_(0), next_step_(0), 
+sum_counts_(0), next_bin_(0), last_latency_(0.),
+max_latency_(0.), stop_(false), running_(false) {
+    
+    if (bin_size<=0 || step<0) {
+        throw std::runtime_error("Bin size should be larger than 0 and step should not be negative.");
+    }
+    
+    if (step==0) { step_ = bin_size_; }
+    
+    if (index>=decoder.n_union()) {
+        throw std::runtime_error("Union index out of bounds.");
+    }
+    
+    // const decoding methods require precomputed likelihoods
+    decoder.prepare();
+    
+    unsigned int n = decoder.nsources();
+    
+    for (unsigned int source=0; source<n; ++source) {
+        ndim_.push_back( decoder.likelihood(source, index)->ndim_events() );
+        buffers_.emplace_back( new EventBuffer( ndim_.back(), capacity ) );
+    }
+    
+    capacity_ = n>0 ? buffers_[0]->capacity() : capacity;
+    
+    for (unsigned int source=0; source<n; ++source) {
+        window_times_.emplace_back( capacity_ );
+        window_events_.emplace_back( capacity_ * ndim_[source] );
+    }
+    
+    window_begin_.assign( n, 0 );
+    window_end_.assign( n, 0 );
+    dropped_.assign( n, 0 );
+    
+    events_ptr_.assign( n, nullptr );
+    events_n_.assign( n, 0 );
+    posterior_.assign( decoder.grid_size(index), 0. );
+    
+    // decode overlapping bins from steps if bin size is a multiple of step
+    unsigned int m = std::round( bin_size_/step_ );
+    
+    if (m>1 && std::abs( m*step_ - bin_size_ ) <= 1e-6*bin_size_) {
+        window_ = m;
+        step_logL_.assign( window_ * posterior_.size(), 0. );
+        step_counts_.assign( window_, 0 );
+        sum_logL_.assign( posterior_.size(), 0. );
+    }
+}
+
+StreamingDecoder::~StreamingDecoder() {
+    try {
+        stop();
+    } catch (...) {}
+}
+
+// properties
+const Decoder & StreamingDecoder::decoder() const { return *decoder_; }
+unsigned int StreamingDecoder::nsources() const { return buffers_.size(); }
+
+unsigned int StreamingDecoder::ndim_events( unsigned int source ) const {
+    if (source>=nsources()) {
+        throw std::runtime_error("Source index out of bounds.");
+    }
+    return ndim_[source];
+}
+
+value StreamingDecoder::bin_size() const { return bin_size_; }
+value StreamingDecoder::step() const { return step_; }
+unsigned int StreamingDecoder::capacity() const { return capacity_; }
+unsigned int StreamingDecoder::index() const { return index_; }
+bool StreamingDecoder::normalize() const { return normalize_; }
+unsigned int StreamingDecoder::grid_size() const { return posterior_.size(); }
+unsigned int StreamingDecoder::window() const { return window_; }
+
+unsigned long StreamingDecoder::next_bin() const { return next_bin_.load(); }
+double StreamingDecoder::next_bin_start() const { return origin_ + next_bin_.load()*step_; }
+double StreamingDecoder::next_bin_stop() const { return next_bin_start() + bin_size_; }
+
+unsigned long StreamingDecoder::dropped( unsigned int source ) const {
+    if (source>=nsources()) {
+        throw std::runtime_error("Source index out of bounds.");
+    }
+    return buffers_[source]->dropped() + dropped_[source];
+}
+
+double StreamingDecoder::last_latency() const { return last_latency_.load(); }
+double StreamingDecoder::max_latency() const { return max_latency_.load(); }
+
+// producer methods
+bool StreamingDecoder::push( unsigned int source, double time, const value * event ) {
+    return push( source, &time, event, 1 )==1;
+}
+
+unsigned int StreamingDecoder::push( unsigned int source, const double * times, 
+    const value * events, unsigned int n ) {
+    
+    if (source>=nsources()) {
+        throw std::runtime_error("Source index out of bounds.");
+    }
+    
+    return buffers_[source]->push( times, events, n );
+}
+
+// consumer methods
+unsigned int StreamingDecoder::process( double time, const Callback & fcn ) {
+    
+    if (running()) {
+        throw std::runtime_error("Streaming decoder is running.");
+    }
+    
+    auto due = clock::now();
+    
+    unsigned int n = 0;
+    
+    while (next_bin_stop()<=time) {
+        emit_( due, fcn );
+        ++n;
+    }
+    
+    // keep ring buffers from filling up while no bin is due
+    for (unsigned int source=0; source<nsources(); ++source) {
+        drain_( source );
+    }
+    
+    return n;
+}
+
+void StreamingDecoder::start( Callback fcn ) {
+    
+    if (running()) {
+        throw std::runtime_error("Streaming decoder is already running.");
+    }
+    
+    decoder_->prepare();
+    
+    callback_ = fcn;
+    stop_ = false;
+    error_ = nullptr;
+    
+    // stream time starts at beginning of next bin
+    epoch_ = clock::now() - std::chrono::duration_cast<clock::duration>( 
+        std::chrono::duration<double>( next_bin_start() ) );
+    
+    running_ = true;
+    thread_ = std::thread( &StreamingDecoder::run_, this );
+}
+
+void StreamingDecoder::stop() {
+    
+    if (!thread_.joinable()) { return; }
+    
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    
+    wake_.notify_all();
+    thread_.join();
+    running_ = false;
+    
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception( error );
+    }
+}
+
+bool StreamingDecoder::running() const { return running_.load(); }
+
+double StreamingDecoder::time() const {
+    return std::chrono::duration<double>( clock::now() - epoch_ ).count();
+}
+
+// move new events from ring buffer to window
+void StreamingDecoder::drain_( unsigned int source ) {
+    
+    EventBuffer & buffer = *buffers_[source];
+    auto & times = window_times_[source];
+    auto & events = window_events_[source];
+    unsigned int & begin = window_begin_[source];
+    unsigned int & end = window_end_[source];
+    unsigned int ndim = ndim_[source];
+    
+    // move retained events to front of window if needed to make space
+    if (begin>0 && end + buffer.size() > capacity_) {
+        std::copy( times.begin() + begin, times.begin() + end, times.begin() );
+        std::copy( events.begin() + begin*ndim, events.begin() + end*ndim, events.begin() );
+        end -= begin;
+        begin = 0;
+    }
+    
+    unsigned int n = buffer.pop( times.data() + end, events.data() + end*ndim, 
+        capacity_ - end );
+    
+    // drop events that are no longer needed or that are out of order
+    double lower = retained_start_();
+    if (end>begin) { lower = std::max( lower, times[end-1] ); }
+    
+    unsigned int keep = end;
+    
+    for (unsigned int k=end; k<end+n; ++k) {
+        if (times[k]<lower) {
+            ++dropped_[source];
+            continue;
+        }
+        
+        lower = times[k];
+        
+        if (keep!=k) {
+            times[keep] = times[k];
+            std::copy( events.begin() + k*ndim, events.begin() + (k+1)*ndim,
+                events.begin() + keep*ndim );
+        }
+        
+        ++keep;
+    }
+    
+    end = keep;
+}
+
+double StreamingDecoder::retained_start_() const {
+    if (window_>0) {
+        return origin_ + next_step_*step_;
+    }
+    return next_bin_start();
+}
+
+unsigned int StreamingDecoder::select_( double start, double stop ) {
+    
+    unsigned int nevents = 0;
+    
+    for (unsigned int source=0; source<nsources(); ++source) {
+        
+        drain_( source );
+        
+        auto & times = window_times_[source];
+        
+        unsigned int lo = std::lower_bound( times.begin() + window_begin_[source], 
+            times.begin() + window_end_[source], start ) - times.begin();
+        unsigned int hi = std::lower_bound( times.begin() + lo, 
+            times.begin() + window_end_[source], stop ) - times.begin();
+        
+        events_ptr_[source] = window_events_[source].data() + lo*ndim_[source];
+        events_n_[source] = (hi-lo)*ndim_[source];
+        nevents += hi-lo;
+    }
+    
+    return nevents;
+}
+
+// decode next bin
+void StreamingDecoder::emit_( clock::time_point due, const Callback & fcn ) {
+    
+    unsigned long k = next_bin_.load();
+    double start = next_bin_start();
+    double stop = start + bin_size_;
+    
+    unsigned int nevents;
+    
+    if (window_==0) {
+        
+        nevents = select_( start, stop );
+        
+        std::fill( posterior_.begin(), posterior_.end(), 0. );
+        
+        static_cast<const Decoder&>(*decoder_).decode( events_ptr_, events_n_, 
+            bin_size_, posterior_.data(), index_, normalize_ );
+        
+    } else {
+        
+        unsigned int G = posterior_.size();
+        
+        // the sum is recomputed once every window, such that rounding 
+        // errors of the running sum do not accumulate
+        bool recompute = k % window_ == 0;
+        
+        // log likelihood of steps up to the last step of the bin, each
+        // event is evaluated only once
+        for (; next_step_<k+window_; ++next_step_) {
+            
+            unsigned int slot = next_step_ % window_;
+            value * logL = step_logL_.data() + slot*G;
+            
+            if (!recompute) {
+                std::transform( sum_logL_.begin(), sum_logL_.end(), logL, 
+                    sum_logL_.begin(), std::minus<value>() );
+                sum_counts_ -= step_counts_[slot];
+            }
+            
+            double t = origin_ + next_step_*step_;
+            step_counts_[slot] = select_( t, t + step_ );
+            
+            std::fill( logL, logL + G, 0. );
+            decoder_->logL( events_ptr_, events_n_, step_, logL, index_ );
+            
+            if (!recompute) {
+                std::transform( sum_logL_.begin(), sum_logL_.end(), logL, 
+                    sum_logL_.begin(), std::plus<value>() );
+                sum_counts_ += step_counts_[slot];
+            }
+        }
+        
+        if (recompute) {
+            std::fill( sum_logL_.begin(), sum_logL_.end(), 0. );
+            sum_counts_ = 0;
+            for (unsigned int slot=0; slot<window_; ++slot) {
+                std::transform( sum_logL_.begin(), sum_logL_.end(), 
+                    step_logL_.begin() + slot*G, sum_logL_.begin(), std::plus<value>() );
+                sum_counts_ += step_counts_[slot];
+            }
+        }
+        
+        nevents = sum_counts_;
+        
+        // the rate term of the summed steps is n*log(step) instead
+        // of n*log(bin_size)
+        value constant = nevents * std::log( (value) window_ );
+        std::transform( sum_logL_.begin(), sum_logL_.end(), posterior_.begin(), 
+            [constant](const value & a) { return a + constant; } );
+        
+        compute_posterior( posterior_.data(), decoder_->prior(index_), G, normalize_ );
+    }
+    
+    double latency = std::chrono::duration<double>( clock::now() - due ).count();
+    last_latency_ = latency;
+    if (latency>max_latency_) { max_latency_ = latency; }
+    
+    if (fcn) {
+        fcn( Bin{ k, start, stop, nevents, latency, posterior_.data() } );
+    }
+    
+    ++next_bin_;
+    
+    // release events that are no longer needed
+    start = retained_start_();
+    
+    for (unsigned int source=0; source<nsources(); ++source) {
+        auto & times = window_times_[source];
+        window_begin_[source] = std::lower_bound( times.begin() + window_begin_[source], 
+            times.begin() + window_end_[source], start ) - times.begin();
+    }
+}
+
+// fixed cadence loop
+void StreamingDecoder::run_() {
+    
+    std::unique_lock<std::mutex> guard(lock_);
+    
+    while (!stop_) {
+        
+        auto due = epoch_ + std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>( next_bin_stop() ) );
+        
+        if (wake_.wait_until( guard, due, [this]{ return stop_; } )) { break; }
+        
+        guard.unlock();
+        
+        try {
+            emit_( due, callback_ );
+        } catch (...) {
+            error_ = std::current_exception();
+            guard.lock();
+            break;
+        }
+        
+        guard.lock();
+    }
+}
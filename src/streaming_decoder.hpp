@@ -0,0 +1,192 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include "common.hpp"
+#include "decoder.hpp"
+#include "event_buffer.hpp"
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <exception>
+
+// default number of events per source that can be buffered by a StreamingDecoder
+static const unsigned int DEFAULT_STREAM_CAPACITY = 4096;
+
+// Long-lived decoder for continuous streams of events. Each source has a
+// lock-free ring buffer that is filled by a single producer thread. The
+// consumer (the thread that calls process, or the internal thread started
+// with start) moves events into a window for each source and decodes bins
+// of duration bin_size that start every step seconds, such that bins
+// overlap if step is smaller than bin_size. Bin k covers the time interval
+// [origin + k*step, origin + k*step + bin_size). Event and posterior buffers
+// are allocated at construction.
+//
+// If bin_size is a multiple of step, the log likelihood of each step is
+// computed once and bins are decoded from a running sum over the last
+// bin_size/step steps, such that the cost of decoding does not grow with
+// the overlap of bins.
+//
+// The decoder is referenced and should outlive the streaming decoder.
+// Likelihoods are prepared at construction and should not be modified
+// while streaming.
+class StreamingDecoder {
+public:
+    typedef std::chrono::steady_clock clock;
+    
+    // emitted time bin, the posterior is owned by the streaming decoder 
+    // and is only valid during the callback
+    struct Bin {
+        unsigned long index;
+        double start;
+        double stop;
+        unsigned int nevents;
+        // seconds from the moment the bin was due until its posterior
+        // was computed
+        double latency;
+        const value * posterior;
+    };
+    
+    typedef std::function<void(const Bin &)> Callback;
+    
+    // constructor, step = 0 selects non-overlapping bins (step = bin_size)
+    StreamingDecoder( Decoder & decoder, value bin_size, value step = 0,
+        unsigned int capacity = DEFAULT_STREAM_CAPACITY, unsigned int index = 0,
+        bool normalize = true, double origin = 0. );
+    ~StreamingDecoder();
+    
+    StreamingDecoder( const StreamingDecoder & ) = delete;
+    StreamingDecoder & operator=( const StreamingDecoder & ) = delete;
+    
+    // properties
+    const Decoder & decoder() const;
+    unsigned int nsources() const;
+    unsigned int ndim_events( unsigned int source ) const;
+    value bin_size() const;
+    value step() const;
+    unsigned int capacity() const;
+    unsigned int index() const;
+    bool normalize() const;
+    unsigned int grid_size() const;
+    // number of steps per bin if bins are decoded from running sums
+    // of steps, or 0 if every bin is decoded separately
+    unsigned int window() const;
+    
+    // index and time interval of the next bin that will be emitted
+    unsigned long next_bin() const;
+    double next_bin_start() const;
+    double next_bin_stop() const;
+    
+    // number of events of a source that were dropped, because the buffers
+    // were full or the events were too late or out of order (to be called
+    // from the consumer thread or when not running)
+    unsigned long dropped( unsigned int source ) const;
+    
+    // latency of last emitted bin and maximum latency in seconds
+    double last_latency() const;
+    double max_latency() const;
+    
+    // producer methods, events of a source should be pushed from a single 
+    // thread in non-decreasing time order.
+    // Returns whether the event was buffered.
+    bool push( unsigned int source, double time, const value * event );
+    // Returns the number of buffered events.
+    unsigned int push( unsigned int source, const double * times, 
+        const value * events, unsigned int n );
+    
+    // consumer method, emits all bins that end at or before time and
+    // returns the number of emitted bins. Latency is measured from the 
+    // moment process is called.
+    unsigned int process( double time, const Callback & fcn );
+    
+    // emit bins at a fixed cadence from an internal thread. The stream time
+    // (see time) is set to the start of the next bin and each bin is emitted
+    // as soon as it ends, with latency measured from the end of the bin.
+    void start( Callback fcn );
+    void stop();
+    bool running() const;
+    
+    // current stream time in seconds when running, for time stamping events
+    double time() const;
+    
+protected:
+    // start time of oldest events that are still needed
+    double retained_start_() const;
+    // select events in [start, stop) for decoding and return number of events
+    unsigned int select_( double start, double stop );
+    void drain_( unsigned int source );
+    void emit_( clock::time_point due, const Callback & fcn );
+    void run_();
+    
+protected:
+    Decoder * decoder_;
+    
+    value bin_size_;
+    value step_;
+    unsigned int index_;
+    bool normalize_;
+    double origin_;
+    
+    std::vector<unsigned int> ndim_;
+    
+    std::vector<std::unique_ptr<EventBuffer>> buffers_;
+    
+    // per source window of events that have been taken from the ring buffer,
+    // events [begin, end) are time ordered
+    unsigned int capacity_;
+    std::vector<std::vector<double>> window_times_;
+    std::vector<std::vector<value>> window_events_;
+    std::vector<unsigned int> window_begin_;
+    std::vector<unsigned int> window_end_;
+    std::vector<unsigned long> dropped_;
+    
+    // decoding buffers
+    std::vector<value*> events_ptr_;
+    std::vector<unsigned int> events_n_;
+    std::vector<value> posterior_;
+    
+    // log likelihoods and number of events of the last window steps
+    // (each in slot step % window) and their running sum
+    unsigned int window_;
+    unsigned long next_step_;
+    std::vector<value> step_logL_;
+    std::vector<unsigned int> step_counts_;
+    std::vector<value> sum_logL_;
+    unsigned int sum_counts_;
+    
+    std::atomic<unsigned long> next_bin_;
+    std::atomic<double> last_latency_;
+    std::atomic<double> max_latency_;
+    
+    // fixed cadence thread
+    std::thread thread_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    Callback callback_;
+    bool stop_;
+    std::atomic<bool> running_;
+    std::exception_ptr error_;
+    clock::time_point epoch_;
+};
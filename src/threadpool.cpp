@@ -0,0 +1,152 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#include "threadpool.hpp"
+
+#include <stdexcept>
+
+// set while a thread executes work of a thread pool, nested parallel loops
+// run serially to avoid deadlock (and oversubscription)
+static thread_local bool pool_work = false;
+
+// constructor
+ThreadPool::ThreadPool( unsigned int nthreads ) :
+generation_(0), pending_(0), stop_(false) {
+    
+    if (nthreads==0) {
+        throw std::runtime_error("Number of threads should be larger than 0.");
+    }
+    
+    for (unsigned int k=1; k<nthreads; ++k) {
+        threads_.emplace_back( &ThreadPool::worker_, this, k );
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    
+    start_.notify_all();
+    
+    for (auto & t : threads_) {
+        t.join();
+    }
+}
+
+// properties
+unsigned int ThreadPool::nthreads() const { return threads_.size() + 1; }
+
+// methods
+void ThreadPool::run( std::function<void(unsigned int)> fcn ) {
+    
+    // only one job at a time
+    std::lock_guard<std::mutex> run_guard(run_lock_);
+    
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        fcn_ = fcn;
+        error_ = nullptr;
+        pending_ = threads_.size();
+        ++generation_;
+    }
+    
+    start_.notify_all();
+    
+    std::exception_ptr error;
+    
+    bool nested = pool_work;
+    pool_work = true;
+    
+    try {
+        fcn(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    
+    pool_work = nested;
+    
+    std::unique_lock<std::mutex> guard(lock_);
+    done_.wait( guard, [this] { return pending_==0; } );
+    
+    fcn_ = nullptr;
+    
+    if (!error) { error = error_; }
+    
+    if (error) {
+        std::rethrow_exception( error );
+    }
+}
+
+void ThreadPool::worker_( unsigned int index ) {
+    
+    unsigned long generation = 0;
+    
+    while (true) {
+        
+        std::function<void(unsigned int)> fcn;
+        
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            start_.wait( guard, [this, generation] { 
+                return stop_ || generation_!=generation; } );
+            
+            if (stop_) { return; }
+            
+            generation = generation_;
+            fcn = fcn_;
+        }
+        
+        pool_work = true;
+        
+        try {
+            fcn( index );
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!error_) { error_ = std::current_exception(); }
+        }
+        
+        pool_work = false;
+        
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            --pending_;
+        }
+        
+        done_.notify_one();
+    }
+}
+
+void parallel_for( ThreadPool * pool, unsigned int n, 
+    const std::function<void(unsigned int, unsigned int)> & fcn ) {
+    
+    if (pool==nullptr || pool_work || n<2) {
+        for (unsigned int k=0; k<n; ++k) { fcn( k, 0 ); }
+        return;
+    }
+    
+    unsigned int nthreads = pool->nthreads();
+    
+    pool->run( [&](unsigned int worker) {
+        for (unsigned int k=worker; k<n; k+=nthreads) {
+            fcn( k, worker );
+        }
+    });
+}
@@ -0,0 +1,70 @@
+// ---------------------------------------------------------------------
+// This file is part of the compressed decoder library.
+//
+// Copyright (C) 2020 - now Neuro-Electronics Research Flanders
+//
+// The compressed decoder library is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The compressed decoder library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with falcon-core. If not, see <http://www.gnu.org/licenses/>.
+// ---------------------------------------------------------------------
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+// Persistent pool of worker threads. A call to run executes a function on
+// all workers (the calling thread acts as worker 0) and blocks until all
+// workers have finished. Work is distributed by the caller based on the 
+// worker index, such that the assignment of work to workers is fixed.
+class ThreadPool {
+public:
+    // constructor
+    ThreadPool( unsigned int nthreads );
+    ~ThreadPool();
+    
+    ThreadPool( const ThreadPool & ) = delete;
+    ThreadPool & operator=( const ThreadPool & ) = delete;
+    
+    // properties
+    unsigned int nthreads() const;
+    
+    // methods
+    void run( std::function<void(unsigned int)> fcn );
+    
+protected:
+    void worker_( unsigned int index );
+    
+protected:
+    std::vector<std::thread> threads_;
+    
+    std::mutex run_lock_;
+    std::mutex lock_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    
+    std::function<void(unsigned int)> fcn_;
+    unsigned long generation_;
+    unsigned int pending_;
+    bool stop_;
+    std::exception_ptr error_;
+};
+
+// calls fcn(k, worker) for k in [0,n), where k is assigned to worker 
+// k % nthreads of the pool (a fixed assignment, such that per-worker results 
+// can be reduced in a fixed order). The loop runs serially as worker 0 if
+// pool is nullptr or if called from a thread that already runs pool work.
+void parallel_for( ThreadPool * pool, unsigned int n, 
+    const std::function<void(unsigned int, unsigned int)> & fcn );